@@ -0,0 +1,343 @@
+#pragma once
+// In-process benchmark harness shared by task2 and task3.
+// A kernel is timed after config.warmup untimed runs, for at least min_reps
+// repetitions and min_seconds of measured time (capped at max_reps), and the
+// samples are summarized as min / median / p95 / mean / stddev. Given the
+// flops and bytes of one call, a result also reports GFLOPS, GB/s and the
+// roofline bound min(peak GFLOPS, flops/byte x peak GB/s) measured once per
+// process (measure_roofline), with the float peak for cases added as single. BenchSuite collects registered cases, so a
+// parameter sweep is a loop of add() calls, and writes them as CSV or JSON.
+// With perf_enable(true) every case gets one more, untimed call inside a
+// PerfScope, and its hardware counters join the output columns.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include <immintrin.h>
+#include "cpu_dispatch.hpp"
+#include "perf_counters.hpp"
+
+struct BenchConfig {
+    int warmup = 1;
+    int min_reps = 5;
+    int max_reps = 1000;
+    double min_seconds = 0.0;
+};
+
+struct BenchStats {
+    int reps = 0;
+    double min = 0, median = 0, p95 = 0, mean = 0, stddev = 0;
+};
+
+inline BenchStats bench_summarize(std::vector<double> samples) {
+    BenchStats s;
+    s.reps = (int)samples.size();
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    s.min = samples[0];
+    s.median = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    s.p95 = samples[std::min(n - 1, (size_t)std::ceil(0.95 * n) - 1)];  // nearest rank
+    for (double t : samples) s.mean += t;
+    s.mean /= n;
+    for (double t : samples) s.stddev += (t - s.mean) * (t - s.mean);
+    s.stddev = n > 1 ? std::sqrt(s.stddev / (n - 1)) : 0.0;
+    return s;
+}
+
+template <class Fn>
+BenchStats bench_measure(const BenchConfig& config, Fn&& fn) {
+    for (int w = 0; w < config.warmup; ++w) fn();
+    std::vector<double> samples;
+    double total = 0.0;
+    const int min_reps = std::max(1, config.min_reps);
+    const int max_reps = std::max(min_reps, config.max_reps);
+    while ((int)samples.size() < max_reps && ((int)samples.size() < min_reps || total < config.min_seconds)) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        double t = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        samples.push_back(t);
+        total += t;
+    }
+    return bench_summarize(std::move(samples));
+}
+
+// Bandwidth is the DRAM ceiling, so cases whose data stays in cache can go above 100%
+struct Roofline {
+    double peak_gflops = 0;      // double-precision FMAs
+    double peak_gflops_f32 = 0;  // single-precision FMAs
+    double peak_gbps = 0;
+
+    // Upper bound on GFLOPS at the given arithmetic intensity (flops per byte),
+    // for flops done in float when single is set
+    double attainable(double intensity, bool single = false) const {
+        return std::min(single ? peak_gflops_f32 : peak_gflops, intensity * peak_gbps);
+    }
+};
+
+namespace bench_detail {
+constexpr int FMA_CHAINS = 12;  // independent accumulators, enough to hide FMA latency
+
+// FMA throughput loops, one per ISA; each returns a value that depends on all
+// accumulators so the loop cannot be dropped
+inline double fma_loop_scalar(long iters) {
+    double acc[FMA_CHAINS];
+    for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = j;
+    for (long i = 0; i < iters; ++i)
+        #pragma GCC unroll 12
+        for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = acc[j] * 0.999999 + 1e-7;
+    double sum = 0;
+    for (int j = 0; j < FMA_CHAINS; ++j) sum += acc[j];
+    return sum;
+}
+
+__attribute__((target("sse2"))) inline double fma_loop_sse2(long iters) {
+    __m128d acc[FMA_CHAINS];
+    const __m128d m = _mm_set1_pd(0.999999), a = _mm_set1_pd(1e-7);
+    for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm_set1_pd(j);
+    for (long i = 0; i < iters; ++i)
+        #pragma GCC unroll 12
+        for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm_add_pd(_mm_mul_pd(acc[j], m), a);
+    double sum = 0;
+    for (int j = 0; j < FMA_CHAINS; ++j) sum += _mm_cvtsd_f64(acc[j]);
+    return sum;
+}
+
+__attribute__((target("avx2,fma"))) inline double fma_loop_avx2(long iters) {
+    __m256d acc[FMA_CHAINS];
+    const __m256d m = _mm256_set1_pd(0.999999), a = _mm256_set1_pd(1e-7);
+    for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm256_set1_pd(j);
+    for (long i = 0; i < iters; ++i)
+        #pragma GCC unroll 12
+        for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm256_fmadd_pd(acc[j], m, a);
+    double sum = 0;
+    for (int j = 0; j < FMA_CHAINS; ++j) sum += _mm256_cvtsd_f64(acc[j]);
+    return sum;
+}
+
+__attribute__((target("avx512f"))) inline double fma_loop_avx512(long iters) {
+    __m512d acc[FMA_CHAINS];
+    const __m512d m = _mm512_set1_pd(0.999999), a = _mm512_set1_pd(1e-7);
+    for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm512_set1_pd(j);
+    for (long i = 0; i < iters; ++i)
+        #pragma GCC unroll 12
+        for (int j = 0; j < FMA_CHAINS; ++j) acc[j] = _mm512_fmadd_pd(acc[j], m, a);
+    double sum = 0;
+    alignas(64) double lanes[8];
+    for (int j = 0; j < FMA_CHAINS; ++j) {
+        _mm512_store_pd(lanes, acc[j]);
+        sum += lanes[0];
+    }
+    return sum;
+}
+
+inline double env_or_zero(const char* name) {
+    const char* value = std::getenv(name);
+    return value ? std::atof(value) : 0.0;
+}
+}  // namespace bench_detail
+
+// Double-precision peak of the given ISA on all threads (FMA chains held in
+// registers) and memory bandwidth from a STREAM-style triad on arrays well
+// beyond the LLC. BENCH_PEAK_GFLOPS / BENCH_PEAK_GBPS skip either measurement.
+// The float peak is the double peak times the lane ratio: packed float FMAs
+// issue at the same rate with twice the lanes, scalar ones with the same one.
+inline Roofline measure_roofline(Isa isa = detect_isa()) {
+    Roofline roof;
+    roof.peak_gflops = bench_detail::env_or_zero("BENCH_PEAK_GFLOPS");
+    roof.peak_gbps = bench_detail::env_or_zero("BENCH_PEAK_GBPS");
+
+    if (roof.peak_gflops <= 0) {
+        const long iters = 1 << 22;
+        const int lanes = isa == Isa::AVX512 ? 8 : isa == Isa::AVX2 ? 4 : isa == Isa::SSE2 ? 2 : 1;
+        const double flops_per_iter = 2.0 * bench_detail::FMA_CHAINS * lanes;
+        volatile double sink = 0;
+        BenchConfig config;
+        config.min_reps = config.max_reps = 3;
+        BenchStats s = bench_measure(config, [&] {
+            double sum = 0;
+            #pragma omp parallel
+            {
+                double r;
+                switch (isa) {
+                    case Isa::AVX512: r = bench_detail::fma_loop_avx512(iters); break;
+                    case Isa::AVX2:   r = bench_detail::fma_loop_avx2(iters); break;
+                    case Isa::SSE2:   r = bench_detail::fma_loop_sse2(iters); break;
+                    default:          r = bench_detail::fma_loop_scalar(iters); break;
+                }
+                #pragma omp atomic
+                sum += r;
+            }
+            sink = sum;
+        });
+        roof.peak_gflops = flops_per_iter * iters * omp_get_max_threads() / s.min / 1e9;
+    }
+    roof.peak_gflops_f32 = roof.peak_gflops * (isa == Isa::Scalar ? 1 : 2);
+
+    if (roof.peak_gbps <= 0) {
+        const long n = 1L << 23;  // 64 MB per array
+        std::vector<double> a(n), b(n), c(n);
+        #pragma omp parallel for schedule(static)
+        for (long i = 0; i < n; ++i) { a[i] = 0.0; b[i] = 1.0; c[i] = 2.0; }
+        BenchConfig config;
+        config.min_reps = config.max_reps = 3;
+        BenchStats s = bench_measure(config, [&] {
+            #pragma omp parallel for schedule(static)
+            for (long i = 0; i < n; ++i) a[i] = b[i] + 3.0 * c[i];
+        });
+        roof.peak_gbps = 3.0 * n * sizeof(double) / s.min / 1e9;
+    }
+    return roof;
+}
+
+// measure_roofline(), run at most once per process: the ISA of the first call
+// wins, so programs with an --isa override should call this once after parsing it
+inline const Roofline& machine_roofline(Isa isa = detect_isa()) {
+    static const Roofline roof = measure_roofline(isa);
+    return roof;
+}
+
+template <class T>
+std::string bench_str(const T& value) {
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+struct BenchResult {
+    std::string kernel;
+    std::vector<std::pair<std::string, std::string>> params;  // sweep parameters, in column order
+    double flops = 0;   // per call
+    double bytes = 0;   // per call (compulsory traffic)
+    BenchStats stats;
+    bool single = false;         // flops done in float, bounded by the float peak
+    double roofline_gflops = 0;  // attainable at this case's intensity
+    PerfRegionStats counters;    // one extra call, when perf_enabled()
+
+    double gflops() const { return stats.median > 0 ? flops / stats.median / 1e9 : 0.0; }
+    double gbps() const { return stats.median > 0 ? bytes / stats.median / 1e9 : 0.0; }
+    double roofline_fraction() const { return roofline_gflops > 0 ? gflops() / roofline_gflops : 0.0; }
+};
+
+class BenchSuite {
+public:
+    using Params = std::vector<std::pair<std::string, std::string>>;
+
+    // kernel_column names the kernel column in CSV output ("Mode" in task3)
+    explicit BenchSuite(BenchConfig config = {}, std::string kernel_column = "Kernel")
+        : config_(config), kernel_column_(std::move(kernel_column)) {}
+
+    // Registers one case; fn is what gets timed, so allocate and initialize before.
+    // single marks flops done in float, which are held to the float peak.
+    void add(const std::string& kernel, Params params, double flops, double bytes, std::function<void()> fn,
+             bool single = false) {
+        BenchResult r;
+        r.kernel = kernel;
+        r.params = std::move(params);
+        r.flops = flops;
+        r.bytes = bytes;
+        r.single = single;
+        results_.push_back(std::move(r));
+        pending_.push_back(std::move(fn));
+    }
+
+    // Runs the cases added since the last call (so a sweep can free each
+    // point's data before building the next) and returns all results so far
+    const std::vector<BenchResult>& run(bool verbose = true) {
+        size_t first = results_.size() - pending_.size();
+        for (size_t c = 0; c < pending_.size(); ++c) {
+            BenchResult& r = results_[first + c];
+            r.stats = bench_measure(config_, pending_[c]);
+            if (r.flops > 0 && r.bytes > 0) r.roofline_gflops = machine_roofline().attainable(r.flops / r.bytes, r.single);
+            if (perf_enabled()) {
+                std::string region = "bench/" + std::to_string(first + c);
+                {
+                    PerfScope scope(region, PerfScope::Call);
+                    pending_[c]();
+                }
+                r.counters = perf_region(region);
+            }
+            if (verbose) print(r);
+        }
+        pending_.clear();
+        return results_;
+    }
+
+    const std::vector<BenchResult>& results() const { return results_; }
+
+    // One row per case: parameters, kernel, then the statistics. Time is the
+    // median, so files that only read Time keep their meaning.
+    void write_csv(const std::string& path) const {
+        std::ofstream out(path);
+        if (results_.empty()) return;
+        for (const auto& p : results_[0].params) out << p.first << ",";
+        out << kernel_column_ << ",Time,Min,Median,P95,Mean,Stddev,Reps,GFLOPS,GBps,RooflineGFLOPS,RooflineFraction";
+        const bool counters = perf_enabled();
+        if (counters) {
+            for (int e = 0; e < PERF_EVENTS; ++e) out << "," << perf_event_name(e);
+            out << ",IPC";
+        }
+        out << "\n";
+        for (const BenchResult& r : results_) {
+            for (const auto& p : r.params) out << p.second << ",";
+            out << r.kernel << "," << r.stats.median << "," << r.stats.min << "," << r.stats.median << ","
+                << r.stats.p95 << "," << r.stats.mean << "," << r.stats.stddev << "," << r.stats.reps << ","
+                << r.gflops() << "," << r.gbps() << "," << r.roofline_gflops << "," << r.roofline_fraction();
+            if (counters) {
+                // Unavailable counters stay empty, so "timing only" runs still load
+                for (int e = 0; e < PERF_EVENTS; ++e) {
+                    out << ",";
+                    if (r.counters.has(e)) out << r.counters.per_call(e);
+                }
+                out << ",";
+                if (r.counters.ipc() > 0) out << r.counters.ipc();
+            }
+            out << "\n";
+        }
+    }
+
+    void write_json(const std::string& path) const {
+        std::ofstream out(path);
+        const Roofline& roof = machine_roofline();
+        out << "{\n  \"roofline\": {\"peak_gflops\": " << roof.peak_gflops
+            << ", \"peak_gflops_f32\": " << roof.peak_gflops_f32 << ", \"peak_gbps\": " << roof.peak_gbps
+            << "},\n  \"results\": [";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const BenchResult& r = results_[i];
+            out << (i ? ",\n" : "\n") << "    {\"kernel\": \"" << r.kernel << "\"";
+            for (const auto& p : r.params) out << ", \"" << p.first << "\": \"" << p.second << "\"";
+            out << ", \"reps\": " << r.stats.reps << ", \"min\": " << r.stats.min << ", \"median\": " << r.stats.median
+                << ", \"p95\": " << r.stats.p95 << ", \"mean\": " << r.stats.mean << ", \"stddev\": " << r.stats.stddev
+                << ", \"gflops\": " << r.gflops() << ", \"gbps\": " << r.gbps()
+                << ", \"roofline_gflops\": " << r.roofline_gflops;
+            for (int e = 0; e < PERF_EVENTS; ++e)
+                if (r.counters.has(e)) out << ", \"" << perf_event_name(e) << "\": " << r.counters.per_call(e);
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    static void print(const BenchResult& r) {
+        std::cout << "  " << r.kernel;
+        for (const auto& p : r.params) std::cout << " " << p.first << "=" << p.second;
+        std::cout << ": median " << r.stats.median << " s (min " << r.stats.min << ", p95 " << r.stats.p95
+                  << ", stddev " << r.stats.stddev << ", " << r.stats.reps << " reps), " << r.gflops() << " GFLOPS, "
+                  << r.gbps() << " GB/s";
+        if (r.roofline_gflops > 0) std::cout << " (" << 100.0 * r.roofline_fraction() << "% of roofline)";
+        std::cout << std::endl;
+    }
+
+private:
+    BenchConfig config_;
+    std::string kernel_column_;
+    std::vector<BenchResult> results_;
+    std::vector<std::function<void()>> pending_;
+};
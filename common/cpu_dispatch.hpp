@@ -0,0 +1,51 @@
+#pragma once
+// Runtime ISA selection shared by task2 and task3.
+// Kernels are compiled once per Isa (see the *_kernels.inc files) and the
+// widest version the CPU supports is picked at startup; --isa=<name> forces one.
+#include <iostream>
+#include <string>
+
+enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+inline const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+inline bool isa_supported(Isa isa) {
+    __builtin_cpu_init();
+    switch (isa) {
+        case Isa::Scalar: return true;
+        case Isa::SSE2:   return __builtin_cpu_supports("sse2");
+        case Isa::AVX2:   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Isa::AVX512: return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+}
+
+// Widest ISA the running CPU (and OS) supports
+inline Isa detect_isa() {
+    for (Isa isa : {Isa::AVX512, Isa::AVX2, Isa::SSE2})
+        if (isa_supported(isa)) return isa;
+    return Isa::Scalar;
+}
+
+// Resolves an override name ("", "auto", "scalar", "sse2", "avx2", "avx512").
+// Unknown names and ISAs this CPU cannot run fall back to detection.
+inline Isa select_isa(const std::string& name) {
+    Isa detected = detect_isa();
+    if (name.empty() || name == "auto") return detected;
+    for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (name != isa_name(isa)) continue;
+        if (isa_supported(isa)) return isa;
+        std::cerr << "Warning: " << name << " not supported on this CPU, using " << isa_name(detected) << std::endl;
+        return detected;
+    }
+    std::cerr << "Warning: unknown ISA '" << name << "', using " << isa_name(detected) << std::endl;
+    return detected;
+}
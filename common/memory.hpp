@@ -0,0 +1,189 @@
+#pragma once
+// Allocation for kernel data (matrices, vectors, CSR arrays) shared by task2 and task3.
+// KernelVector<T> is a std::vector whose elements are default-initialized, so
+// resize() and the size constructor leave large buffers untouched: the pages
+// are placed by whichever thread writes them first (see first_touch in
+// numa.hpp). Under NumaPolicy::Interleave new buffers are interleaved over
+// all nodes instead. Pass a value (v.assign(n, 0), v.resize(n, 0)) where
+// zeros are needed.
+// Every buffer starts on a KERNEL_ALIGNMENT (64-byte, one cache line and one
+// AVX-512 vector) boundary. Buffers of at least HUGE_PAGE_BYTES get their own
+// 2 MB-aligned mapping backed according to page_strategy(): 4 KB pages,
+// transparent huge pages (madvise), or hugetlbfs pages, which fall back to
+// transparent ones when none are reserved (vm.nr_hugepages = 0).
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fstream>
+#include <string>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Where the pages of new kernel buffers go (set once at startup, --numa=<name>)
+enum class NumaPolicy { Serial, FirstTouch, Interleave };
+
+inline const char* numa_policy_name(NumaPolicy policy) {
+    switch (policy) {
+        case NumaPolicy::Serial:     return "serial";
+        case NumaPolicy::FirstTouch: return "first-touch";
+        case NumaPolicy::Interleave: return "interleave";
+    }
+    return "unknown";
+}
+
+inline NumaPolicy& numa_policy() {
+    static NumaPolicy policy = NumaPolicy::FirstTouch;
+    return policy;
+}
+
+// Interleaves the whole pages inside [data, data + bytes) over the online
+// nodes (all of them up to max_node); a no-op on single-node machines
+inline void numa_interleave(void* data, size_t bytes, int max_node) {
+    if (max_node < 1) return;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t)data + page - 1) / page * page;
+    uintptr_t end = ((uintptr_t)data + bytes) / page * page;
+    if (end <= begin) return;
+    unsigned long mask[16] = {};
+    for (int node = 0; node <= max_node && node < 16 * 64; ++node) mask[node / 64] |= 1UL << (node % 64);
+    syscall(SYS_mbind, (void*)begin, end - begin, MPOL_INTERLEAVE, mask, 16 * 64, 0);
+}
+
+// Highest online NUMA node (0 when the sysfs entry is missing)
+inline int numa_highest_node() {
+    static const int max_node = [] {
+        int node = 0;
+        if (FILE* f = std::fopen("/sys/devices/system/node/online", "r")) {
+            int lo, hi;
+            while (std::fscanf(f, "%d", &lo) == 1) {
+                hi = lo;
+                if (std::fscanf(f, "-%d", &hi) != 1) hi = lo;
+                node = std::max(node, hi);
+                if (std::fgetc(f) != ',') break;
+            }
+            std::fclose(f);
+        }
+        return node;
+    }();
+    return max_node;
+}
+
+constexpr size_t KERNEL_ALIGNMENT = 64;
+constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
+// Backing of buffers of HUGE_PAGE_BYTES and more (set once at startup, --pages=<name>)
+enum class PageStrategy { Small, Transparent, HugeTLB };
+
+inline const char* page_strategy_name(PageStrategy strategy) {
+    switch (strategy) {
+        case PageStrategy::Small:       return "small";
+        case PageStrategy::Transparent: return "thp";
+        case PageStrategy::HugeTLB:     return "hugetlb";
+    }
+    return "unknown";
+}
+
+inline PageStrategy& page_strategy() {
+    static PageStrategy strategy = PageStrategy::Transparent;
+    return strategy;
+}
+
+// kB of this process's memory currently on huge pages (transparent and hugetlbfs)
+inline long huge_page_kb() {
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string key;
+    long kb, total = 0;
+    while (smaps >> key) {
+        if ((key == "AnonHugePages:" || key == "Private_Hugetlb:" || key == "Shared_Hugetlb:") && smaps >> kb)
+            total += kb;
+        smaps.ignore(256, '\n');
+    }
+    return total;
+}
+
+namespace memory_detail {
+// Mapped buffers start STAGGER_STEP * (k % STAGGERS) bytes into their mapping.
+// On huge pages the physical address bits below 2 MB equal the virtual ones,
+// so without the offset every buffer (values, col_indices, x, y) would map to
+// the same L2 sets and the streams would evict each other.
+constexpr size_t STAGGER_STEP = 1088;  // 17 cache lines: different sets and 4 KB offsets
+constexpr size_t STAGGERS = 16;
+
+inline size_t mapping_bytes(size_t bytes) {
+    return (bytes + STAGGER_STEP * STAGGERS + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+}
+
+inline size_t next_stagger() {
+    static std::atomic<size_t> count{0};
+    return count++ % STAGGERS * STAGGER_STEP;
+}
+
+inline void* map(size_t bytes) {
+    const size_t size = mapping_bytes(bytes);
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (page_strategy() == PageStrategy::HugeTLB) {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+        if (p != MAP_FAILED) return p;
+    }
+    // Map one huge page more and trim, so the buffer starts on a 2 MB boundary
+    char* raw = (char*)mmap(nullptr, size + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (raw == MAP_FAILED) throw std::bad_alloc();
+    char* p = (char*)(((uintptr_t)raw + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES);
+    if (p > raw) munmap(raw, p - raw);
+    if (raw + HUGE_PAGE_BYTES > p) munmap(p + size, raw + HUGE_PAGE_BYTES - p);
+    madvise(p, size, page_strategy() == PageStrategy::Small ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+    return p;
+}
+}  // namespace memory_detail
+
+template <class T>
+struct KernelAllocator {
+    using value_type = T;
+
+    KernelAllocator() = default;
+    template <class U>
+    KernelAllocator(const KernelAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > std::allocator_traits<std::allocator<T>>::max_size(std::allocator<T>())) throw std::bad_array_new_length();
+        const size_t bytes = n * sizeof(T);
+        if (bytes < HUGE_PAGE_BYTES) return (T*)::operator new(bytes, std::align_val_t(KERNEL_ALIGNMENT));
+        // Small buffers share pages with other data, so only mapped ones are rebound
+        char* base = (char*)memory_detail::map(bytes);
+        if (numa_policy() == NumaPolicy::Interleave)
+            numa_interleave(base, memory_detail::mapping_bytes(bytes), numa_highest_node());
+        return (T*)(base + memory_detail::next_stagger());
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        const size_t bytes = n * sizeof(T);
+        if (bytes < HUGE_PAGE_BYTES) ::operator delete(p, std::align_val_t(KERNEL_ALIGNMENT));
+        else munmap((void*)((uintptr_t)p / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES), memory_detail::mapping_bytes(bytes));
+    }
+
+    // Default-initialize (no zeroing) when no value is given
+    template <class U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new ((void*)p) U;
+    }
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) {
+        ::new ((void*)p) U(std::forward<Args>(args)...);
+    }
+};
+
+template <class T, class U>
+bool operator==(const KernelAllocator<T>&, const KernelAllocator<U>&) { return true; }
+template <class T, class U>
+bool operator!=(const KernelAllocator<T>&, const KernelAllocator<U>&) { return false; }
+
+template <class T>
+using KernelVector = std::vector<T, KernelAllocator<T>>;
@@ -0,0 +1,223 @@
+#pragma once
+// NUMA placement for the OpenMP kernels: node topology, thread pinning,
+// parallel first touch, and a report of where the pages of a buffer ended up.
+// Pages land on the node of the thread that first writes them, so kernel data
+// is initialized with the same static partition the kernel loops over; each
+// thread then streams mostly node-local memory. Pinning uses sched_setaffinity
+// from inside a parallel region, so it works without OMP_PLACES/OMP_PROC_BIND
+// and can be changed between experiments. Linux only; on machines without
+// /sys/devices/system/node everything behaves as a single node.
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// CPUs of each online node, restricted to the process's affinity mask at first use
+struct NumaTopology {
+    std::vector<std::vector<int>> node_cpus;  // nodes with CPUs, in id order
+    std::vector<int> node_ids;                // their sysfs ids (node_cpus[k] is node node_ids[k])
+    std::vector<int> cpu_node;                // node id by cpu id, -1 if not in the mask
+
+    int nodes() const { return (int)node_cpus.size(); }
+    int node_of(int cpu) const { return cpu >= 0 && cpu < (int)cpu_node.size() ? cpu_node[cpu] : -1; }
+};
+
+namespace numa_detail {
+// Parses a sysfs cpulist ("0-3,8,10-11")
+inline std::vector<int> read_cpulist(const std::string& path) {
+    std::vector<int> cpus;
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) return cpus;
+    int lo, hi;
+    while (std::fscanf(f, "%d", &lo) == 1) {
+        hi = lo;
+        if (std::fscanf(f, "-%d", &hi) != 1) hi = lo;
+        for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+        if (std::fgetc(f) != ',') break;
+    }
+    std::fclose(f);
+    return cpus;
+}
+
+inline cpu_set_t& process_mask() {
+    static cpu_set_t mask = [] {
+        cpu_set_t m;
+        CPU_ZERO(&m);
+        if (sched_getaffinity(0, sizeof(m), &m) != 0)
+            for (int c = 0; c < CPU_SETSIZE; ++c) CPU_SET(c, &m);
+        return m;
+    }();
+    return mask;
+}
+}  // namespace numa_detail
+
+inline const NumaTopology& numa_topology() {
+    static const NumaTopology topology = [] {
+        NumaTopology t;
+        const cpu_set_t& mask = numa_detail::process_mask();
+        for (int node = 0; node <= numa_highest_node(); ++node) {
+            std::vector<int> cpus;
+            for (int c : numa_detail::read_cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))
+                if (c < CPU_SETSIZE && CPU_ISSET(c, &mask)) cpus.push_back(c);
+            if (cpus.empty()) continue;
+            t.node_cpus.push_back(cpus);
+            t.node_ids.push_back(node);
+        }
+        if (t.node_cpus.empty()) {
+            t.node_cpus.emplace_back();
+            t.node_ids.push_back(0);
+            for (int c = 0; c < CPU_SETSIZE; ++c)
+                if (CPU_ISSET(c, &mask)) t.node_cpus[0].push_back(c);
+        }
+        for (int node = 0; node < t.nodes(); ++node)
+            for (int c : t.node_cpus[node]) {
+                if (c >= (int)t.cpu_node.size()) t.cpu_node.resize(c + 1, -1);
+                t.cpu_node[c] = t.node_ids[node];
+            }
+        return t;
+    }();
+    return topology;
+}
+
+// None: threads float over the whole mask. Close: thread t on the t-th CPU,
+// filling one node before the next. Spread: round-robin over the nodes.
+enum class PinPolicy { None, Close, Spread };
+
+inline const char* pin_policy_name(PinPolicy policy) {
+    switch (policy) {
+        case PinPolicy::None:   return "none";
+        case PinPolicy::Close:  return "close";
+        case PinPolicy::Spread: return "spread";
+    }
+    return "unknown";
+}
+
+// Pins one thread per CPU of the first max_nodes nodes (0 = all) and sets the
+// OpenMP team size to match; returns the thread count. PinPolicy::None only
+// restores the process mask and the team size.
+inline int pin_threads(PinPolicy policy, int max_nodes = 0) {
+    const NumaTopology& topology = numa_topology();
+    int nodes = max_nodes > 0 ? std::min(max_nodes, topology.nodes()) : topology.nodes();
+    std::vector<int> cpus;
+    if (policy == PinPolicy::Spread) {
+        for (size_t k = 0;; ++k) {
+            size_t before = cpus.size();
+            for (int node = 0; node < nodes; ++node)
+                if (k < topology.node_cpus[node].size()) cpus.push_back(topology.node_cpus[node][k]);
+            if (cpus.size() == before) break;
+        }
+    } else {
+        for (int node = 0; node < nodes; ++node)
+            cpus.insert(cpus.end(), topology.node_cpus[node].begin(), topology.node_cpus[node].end());
+    }
+
+    int threads = (int)cpus.size();
+    omp_set_num_threads(threads);
+    #pragma omp parallel num_threads(threads)
+    {
+        if (policy == PinPolicy::None) {
+            sched_setaffinity(0, sizeof(cpu_set_t), &numa_detail::process_mask());
+        } else {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpus[omp_get_thread_num()], &one);
+            sched_setaffinity(0, sizeof(one), &one);
+        }
+    }
+    return threads;
+}
+
+// Writes every element of data once with the static partition of a
+// `parallel for schedule(static)` over [0, n), which places each page on the
+// node of the thread whose kernel iterations use it. NumaPolicy::Serial does
+// the same from the calling thread (all pages on its node) as the baseline.
+template <class T>
+void first_touch(T* data, size_t n, T value = T()) {
+    if (numa_policy() == NumaPolicy::Serial) {
+        std::fill(data, data + n, value);
+        return;
+    }
+    #pragma omp parallel for schedule(static)
+    for (long long i = 0; i < (long long)n; ++i) data[i] = value;
+}
+
+// Copies (and converts) src into dst with the same placement rules as first_touch
+template <class T, class U>
+void first_touch_copy(const T* src, U* dst, size_t n) {
+    if (numa_policy() == NumaPolicy::Serial) {
+        std::copy(src, src + n, dst);
+        return;
+    }
+    #pragma omp parallel for schedule(static)
+    for (long long i = 0; i < (long long)n; ++i) dst[i] = (U)src[i];
+}
+
+// Node that each thread of the current team runs on (-1 if unknown)
+inline std::vector<int> numa_thread_nodes() {
+    std::vector<int> nodes(omp_get_max_threads(), -1);
+    #pragma omp parallel
+    nodes[omp_get_thread_num()] = numa_topology().node_of(sched_getcpu());
+    return nodes;
+}
+
+// Where the pages of a buffer live relative to the threads that use them.
+// A page is local when it sits on the node of the thread that owns it.
+struct NumaPlacement {
+    std::vector<long> pages_per_node;  // by node id
+    long local = 0, remote = 0, unknown = 0;
+
+    double local_fraction() const { return local + remote > 0 ? (double)local / (local + remote) : 0.0; }
+};
+
+// Queries up to max_pages pages of [data, data + n) with move_pages. bounds
+// holds the element ranges of the threads (bounds[t]..bounds[t + 1]); when
+// empty, the static partition of a `parallel for` over [0, n) is assumed.
+template <class T>
+NumaPlacement numa_placement(const T* data, size_t n, std::vector<size_t> bounds = {}, size_t max_pages = 4096) {
+    NumaPlacement placement;
+    placement.pages_per_node.assign(numa_highest_node() + 1, 0);
+    std::vector<int> thread_nodes = numa_thread_nodes();
+    int threads = (int)thread_nodes.size();
+    if (bounds.empty()) {
+        // libgomp's schedule(static): the first n % threads threads get one extra element
+        size_t chunk = n / threads, extra = n % threads;
+        bounds.push_back(0);
+        for (int t = 0; t < threads; ++t) bounds.push_back(bounds.back() + chunk + ((size_t)t < extra));
+    }
+    if (n == 0) return placement;
+
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (uintptr_t)data / page * page;
+    uintptr_t end = (uintptr_t)(data + n);
+    size_t pages = (end - begin + page - 1) / page;
+    size_t stride = std::max<size_t>(1, pages / max_pages);
+    std::vector<void*> addresses;
+    std::vector<int> owners;
+    for (size_t p = 0; p < pages; p += stride) {
+        uintptr_t address = begin + p * page;
+        size_t element = address < (uintptr_t)data ? 0 : (address - (uintptr_t)data) / sizeof(T);
+        size_t owner = std::upper_bound(bounds.begin(), bounds.end(), element) - bounds.begin() - 1;
+        addresses.push_back((void*)address);
+        owners.push_back(owner < thread_nodes.size() ? thread_nodes[owner] : -1);
+    }
+    std::vector<int> status(addresses.size(), -1);
+    if (syscall(SYS_move_pages, 0, addresses.size(), addresses.data(), nullptr, status.data(), 0) != 0) {
+        placement.unknown = (long)addresses.size();
+        return placement;
+    }
+    for (size_t k = 0; k < addresses.size(); ++k) {
+        int node = status[k];
+        if (node >= 0 && node < (int)placement.pages_per_node.size()) placement.pages_per_node[node]++;
+        if (node < 0 || owners[k] < 0) placement.unknown++;
+        else if (node == owners[k]) placement.local++;
+        else placement.remote++;
+    }
+    return placement;
+}
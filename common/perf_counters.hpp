@@ -0,0 +1,258 @@
+#pragma once
+// Hardware counters per named code region, read in-process with perf_event_open.
+// Each OpenMP thread opens one counter group on first use (cycles, instructions,
+// L1D read misses, LLC misses, branch misses, dTLB read misses; user space only, so the default
+// perf_event_paranoid = 2 is enough). A PerfScope reads the groups of all
+// threads of the team on entry and exit (one short parallel region each) and
+// adds the differences to its region. Events the kernel or the PMU refuses
+// (containers, VMs, paranoid = 3, or a group never scheduled on the PMU) are
+// marked unavailable; regions then still record calls and wall time, without
+// reading the counters. Counting is off until perf_enable(true). Phase scopes
+// inside a kernel only count during a counted call (PerfScope::Call, the one
+// untimed call per case), so timed repetitions do not pay for them.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+enum PerfEvent { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_BRANCH_MISSES, PERF_DTLB_MISSES,
+                 PERF_EVENTS };
+
+// Column names used in the CSV / JSON output
+inline const char* perf_event_name(int event) {
+    static const char* names[PERF_EVENTS] = {"Cycles", "Instructions", "L1DMisses", "LLCMisses", "BranchMisses",
+                                             "DTLBMisses"};
+    return names[event];
+}
+
+// The same as key=value keys in printed output
+inline const char* perf_event_key(int event) {
+    static const char* keys[PERF_EVENTS] = {"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+                                            "dtlb_misses"};
+    return keys[event];
+}
+
+// One thread's counter group; available has bit e set when event e is counting
+class PerfGroup {
+public:
+    PerfGroup() {
+        for (int e = 0; e < PERF_EVENTS; ++e) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type_of(e);
+            attr.config = config_of(e);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0);
+            if (fd < 0) continue;
+            uint64_t id = 0;
+            if (ioctl(fd, PERF_EVENT_IOC_ID, &id) != 0) {
+                close(fd);
+                continue;
+            }
+            if (leader_ < 0) leader_ = fd;
+            fds_.push_back(fd);
+            ids_[e] = id;
+            available |= 1u << e;
+        }
+    }
+    ~PerfGroup() {
+        for (int fd : fds_) close(fd);
+    }
+    PerfGroup(const PerfGroup&) = delete;
+    PerfGroup& operator=(const PerfGroup&) = delete;
+
+    // Current counts since the group was opened, scaled up if the PMU was
+    // multiplexed. Returns the events actually read: none when the read fails
+    // or the group has never been scheduled on the PMU (running = 0).
+    unsigned read(double counts[PERF_EVENTS]) const {
+        for (int e = 0; e < PERF_EVENTS; ++e) counts[e] = 0;
+        if (leader_ < 0) return 0;
+        uint64_t buffer[3 + 2 * PERF_EVENTS];
+        if (::read(leader_, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(uint64_t))) return 0;
+        uint64_t nr = buffer[0], enabled = buffer[1], running = buffer[2];
+        if (running == 0) return 0;
+        double scale = (double)enabled / running;
+        for (uint64_t k = 0; k < nr && k < PERF_EVENTS; ++k)
+            for (int e = 0; e < PERF_EVENTS; ++e)
+                if ((available >> e & 1) && ids_[e] == buffer[4 + 2 * k]) counts[e] = buffer[3 + 2 * k] * scale;
+        return available;
+    }
+
+    unsigned available = 0;
+
+private:
+    static uint32_t type_of(int event) {
+        return event == PERF_L1D_MISSES || event == PERF_DTLB_MISSES ? PERF_TYPE_HW_CACHE : PERF_TYPE_HARDWARE;
+    }
+    static uint64_t config_of(int event) {
+        switch (event) {
+            case PERF_CYCLES:       return PERF_COUNT_HW_CPU_CYCLES;
+            case PERF_INSTRUCTIONS: return PERF_COUNT_HW_INSTRUCTIONS;
+            case PERF_L1D_MISSES:
+                return PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+            case PERF_LLC_MISSES:   return PERF_COUNT_HW_CACHE_MISSES;
+            case PERF_DTLB_MISSES:
+                return PERF_COUNT_HW_CACHE_DTLB | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+            default:                return PERF_COUNT_HW_BRANCH_MISSES;
+        }
+    }
+
+    int leader_ = -1;
+    std::vector<int> fds_;
+    uint64_t ids_[PERF_EVENTS] = {};
+};
+
+inline PerfGroup& perf_thread_group() {
+    thread_local PerfGroup group;
+    return group;
+}
+
+// Totals of one region over all its calls and all threads
+struct PerfRegionStats {
+    std::string name;
+    long calls = 0;
+    double seconds = 0;
+    double counts[PERF_EVENTS] = {};
+    unsigned available = 0;
+
+    bool has(int event) const { return available >> event & 1; }
+    double per_call(int event) const { return calls ? counts[event] / calls : 0.0; }
+    double ipc() const {
+        return has(PERF_CYCLES) && has(PERF_INSTRUCTIONS) && counts[PERF_CYCLES] > 0
+                   ? counts[PERF_INSTRUCTIONS] / counts[PERF_CYCLES] : 0.0;
+    }
+};
+
+namespace perf_detail {
+inline bool& enabled() {
+    static bool on = false;
+    return on;
+}
+inline unsigned& available() {
+    static unsigned events = 0;
+    return events;
+}
+// True while a PerfScope::Call is open
+inline bool& counting() {
+    static bool on = false;
+    return on;
+}
+inline std::mutex& lock() {
+    static std::mutex m;
+    return m;
+}
+inline std::vector<PerfRegionStats>& regions() {
+    static std::vector<PerfRegionStats> list;
+    return list;
+}
+
+// Sum of every team thread's counters; available is the events all of them count
+inline unsigned read_team(double totals[PERF_EVENTS]) {
+    unsigned available = ~0u;
+    for (int e = 0; e < PERF_EVENTS; ++e) totals[e] = 0;
+    #pragma omp parallel
+    {
+        double counts[PERF_EVENTS];
+        unsigned read = perf_thread_group().read(counts);
+        #pragma omp critical(perf_counters)
+        {
+            for (int e = 0; e < PERF_EVENTS; ++e) totals[e] += counts[e];
+            available &= read;
+        }
+    }
+    return available;
+}
+}  // namespace perf_detail
+
+// Turns region counting on or off; returns the events this thread can count
+// (0 means timing only)
+inline unsigned perf_enable(bool on) {
+    perf_detail::enabled() = on;
+    perf_detail::available() = on ? perf_thread_group().available : 0;
+    return perf_detail::available();
+}
+
+inline bool perf_enabled() { return perf_detail::enabled(); }
+
+inline void perf_reset() {
+    std::lock_guard<std::mutex> guard(perf_detail::lock());
+    perf_detail::regions().clear();
+}
+
+// Snapshot of all regions, in order of first use
+inline std::vector<PerfRegionStats> perf_regions() {
+    std::lock_guard<std::mutex> guard(perf_detail::lock());
+    return perf_detail::regions();
+}
+
+inline PerfRegionStats perf_region(const std::string& name) {
+    for (const PerfRegionStats& r : perf_regions())
+        if (r.name == name) return r;
+    PerfRegionStats none;
+    none.name = name;
+    return none;
+}
+
+// Counts everything the team does between construction and destruction under
+// name. Open it outside parallel regions; inside one it is ignored. A Call
+// scope wraps one whole untimed kernel call and is active whenever counting is
+// enabled; Phase scopes (the default, used inside kernels) are active only
+// while a Call scope is open.
+class PerfScope {
+public:
+    enum Kind { Phase, Call };
+
+    explicit PerfScope(std::string name, Kind kind = Phase)
+        : name_(std::move(name)),
+          active_(perf_enabled() && !omp_in_parallel() && (kind == Call || perf_detail::counting())),
+          call_(active_ && kind == Call) {
+        if (!active_) return;
+        if (call_) perf_detail::counting() = true;
+        if (perf_detail::available()) available_ = perf_detail::read_team(start_);
+        start_time_ = std::chrono::high_resolution_clock::now();
+    }
+    ~PerfScope() {
+        if (!active_) return;
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time_).count();
+        double end[PERF_EVENTS] = {};
+        unsigned available = available_ ? available_ & perf_detail::read_team(end) : 0;
+        if (call_) perf_detail::counting() = false;
+
+        std::lock_guard<std::mutex> guard(perf_detail::lock());
+        auto& list = perf_detail::regions();
+        auto it = std::find_if(list.begin(), list.end(), [&](const PerfRegionStats& r) { return r.name == name_; });
+        if (it == list.end()) {
+            list.emplace_back();
+            it = list.end() - 1;
+            it->name = name_;
+            it->available = available;
+        }
+        it->calls++;
+        it->seconds += seconds;
+        it->available &= available;
+        for (int e = 0; e < PERF_EVENTS; ++e) it->counts[e] += end[e] - start_[e];
+    }
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    std::string name_;
+    bool active_;
+    bool call_;
+    unsigned available_ = 0;
+    double start_[PERF_EVENTS] = {};
+    std::chrono::high_resolution_clock::time_point start_time_;
+};
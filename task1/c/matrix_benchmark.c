@@ -5,9 +5,33 @@
 #include <sys/resource.h>
 #include "matrix_c.h"
 
+// Implementations compared by the benchmark. IMPL_BASIC is the original
+// double** version; the others run on contiguous AlignedMatrix storage.
+typedef enum {
+    IMPL_BASIC,
+    IMPL_IKJ,
+    IMPL_TILED,
+    IMPL_OMP,
+    IMPL_COUNT
+} Implementation;
+
+static const char* impl_names[IMPL_COUNT] = {"basic", "ikj", "tiled", "omp"};
+static const char* impl_labels[IMPL_COUNT] = {"C", "C-ikj", "C-tiled", "C-omp"};
+
+// Operands for one benchmark run; only the set matching the implementation is allocated
+typedef struct {
+    double** a;
+    double** b;
+    double** c;
+    AlignedMatrix am;
+    AlignedMatrix bm;
+    AlignedMatrix cm;
+} Operands;
+
 // Forward declarations
-void run_benchmark_with_results(int n, int iterations, double* avg_time_out, double* min_time_out,
-                                 double* max_time_out, long* mem_kb_out, double* gflops_out);
+void run_benchmark_with_results(int n, int iterations, Implementation impl, double* avg_time_out,
+                                 double* min_time_out, double* max_time_out, long* mem_kb_out,
+                                 double* gflops_out);
 
 double get_time_seconds(struct timeval start, struct timeval stop) {
     return (stop.tv_sec - start.tv_sec) + (stop.tv_usec - start.tv_usec) * 1e-6;
@@ -51,25 +75,73 @@ void print_memory_stats(const char* label, int n) {
     }
 }
 
+static void allocate_operands(Operands* ops, int n, Implementation impl) {
+    if (impl == IMPL_BASIC) {
+        ops->a = create_matrix(n);
+        ops->b = create_matrix(n);
+        ops->c = create_matrix(n);
+        initialize_random_matrix(ops->a, n, 42);
+        initialize_random_matrix(ops->b, n, 43);
+        initialize_zero_matrix(ops->c, n);
+    } else {
+        ops->am = create_aligned_matrix(n);
+        ops->bm = create_aligned_matrix(n);
+        ops->cm = create_aligned_matrix(n);
+        if (ops->am.data == NULL || ops->bm.data == NULL || ops->cm.data == NULL) {
+            fprintf(stderr, "Error: aligned allocation failed for n=%d\n", n);
+            exit(1);
+        }
+        initialize_random_aligned_matrix(&ops->am, 42);
+        initialize_random_aligned_matrix(&ops->bm, 43);
+        initialize_zero_aligned_matrix(&ops->cm);
+    }
+}
+
+static void free_operands(Operands* ops, int n, Implementation impl) {
+    if (impl == IMPL_BASIC) {
+        free_matrix(ops->a, n);
+        free_matrix(ops->b, n);
+        free_matrix(ops->c, n);
+    } else {
+        free_aligned_matrix(&ops->am);
+        free_aligned_matrix(&ops->bm);
+        free_aligned_matrix(&ops->cm);
+    }
+}
+
+static void multiply_operands(Operands* ops, int n, Implementation impl) {
+    switch (impl) {
+        case IMPL_BASIC: matrix_multiply(ops->a, ops->b, ops->c, n); break;
+        case IMPL_IKJ:   matrix_multiply_ikj(&ops->am, &ops->bm, &ops->cm); break;
+        case IMPL_TILED: matrix_multiply_tiled(&ops->am, &ops->bm, &ops->cm, DEFAULT_TILE_SIZE); break;
+        case IMPL_OMP:   matrix_multiply_omp(&ops->am, &ops->bm, &ops->cm, DEFAULT_TILE_SIZE); break;
+        default: break;
+    }
+}
+
+static void reset_result(Operands* ops, int n, Implementation impl) {
+    if (impl == IMPL_BASIC) {
+        initialize_zero_matrix(ops->c, n);
+    } else {
+        initialize_zero_aligned_matrix(&ops->cm);
+    }
+}
+
 void run_benchmark(int n, int iterations) {
     double avg_time, min_time, max_time, gflops;
     long mem_kb;
-    run_benchmark_with_results(n, iterations, &avg_time, &min_time, &max_time, &mem_kb, &gflops);
+    run_benchmark_with_results(n, iterations, IMPL_BASIC, &avg_time, &min_time, &max_time, &mem_kb, &gflops);
 }
 
-void run_benchmark_with_results(int n, int iterations, double* avg_time_out, double* min_time_out,
-                                 double* max_time_out, long* mem_kb_out, double* gflops_out) {
-    printf("\n=== Benchmarking %dx%d matrices ===\n", n, n);
+void run_benchmark_with_results(int n, int iterations, Implementation impl, double* avg_time_out,
+                                 double* min_time_out, double* max_time_out, long* mem_kb_out,
+                                 double* gflops_out) {
+    printf("\n=== Benchmarking %dx%d matrices (%s) ===\n", n, n, impl_names[impl]);
 
     long mem_before = get_memory_usage_kb();
 
-    double** a = create_matrix(n);
-    double** b = create_matrix(n);
-    double** c = create_matrix(n);
-
-    initialize_random_matrix(a, n, 42);
-    initialize_random_matrix(b, n, 43);
-    initialize_zero_matrix(c, n);
+    Operands ops;
+    allocate_operands(&ops, n, impl);
 
     long mem_after_alloc = get_memory_usage_kb();
     long mem_allocated = mem_after_alloc - mem_before;
@@ -90,16 +162,16 @@ void run_benchmark_with_results(int n, int iterations, double* avg_time_out, dou
     // Warmup
     printf("Warming up...\n");
     for (int iter = 0; iter < 2; iter++) {
-        matrix_multiply(a, b, c, n);
+        multiply_operands(&ops, n, impl);
     }
 
     // Actual benchmark
     printf("Running %d measurement iterations...\n", iterations);
     for (int iter = 0; iter < iterations; iter++) {
-        initialize_zero_matrix(c, n);
+        reset_result(&ops, n, impl);
 
         gettimeofday(&start, NULL);
-        matrix_multiply(a, b, c, n);
+        multiply_operands(&ops, n, impl);
         gettimeofday(&stop, NULL);
 
         double iter_time = get_time_seconds(start, stop);
@@ -114,7 +186,7 @@ void run_benchmark_with_results(int n, int iterations, double* avg_time_out, dou
     double avg_time = total_time / iterations;
     double gflops = (2.0 * n * n * n / avg_time) / 1e9;
 
-    printf("\n--- Results for %dx%d ---\n", n, n);
+    printf("\n--- Results for %dx%d (%s) ---\n", n, n, impl_names[impl]);
     printf("Iterations: %d\n", iterations);
     printf("Average time: %.6f s (%.2f ms)\n", avg_time, avg_time * 1000);
     printf("Min time: %.6f s\n", min_time);
@@ -131,9 +203,7 @@ void run_benchmark_with_results(int n, int iterations, double* avg_time_out, dou
     *mem_kb_out = get_memory_usage_kb();
     *gflops_out = gflops;
 
-    free_matrix(a, n);
-    free_matrix(b, n);
-    free_matrix(c, n);
+    free_operands(&ops, n, impl);
 }
 
 int main(void) {
@@ -150,32 +220,38 @@ int main(void) {
     printf("========================================\n");
     printf("Matrix Multiplication Benchmark (C)\n");
     printf("========================================\n");
-    printf("Algorithm: Basic O(n^3)\n");
-    printf("Compiler: GCC with -O2 optimization\n");
+    printf("Algorithms: basic (double**), ikj, tiled (%d), omp (%d) on aligned storage\n",
+           DEFAULT_TILE_SIZE, DEFAULT_TILE_SIZE);
+    printf("Compiler: GCC with -O2 optimization, OpenMP\n");
     printf("Data type: double (8 bytes)\n");
     printf("========================================\n");
 
     for (int i = 0; i < num_sizes; i++) {
         int n = sizes[i];
-        double avg_time, min_time, max_time, gflops;
-        long mem_kb;
-
-        // Run benchmark and capture results
-        run_benchmark_with_results(n, iterations, &avg_time, &min_time, &max_time, &mem_kb, &gflops);
-
-        // Write to CSV
-        if (csv_file != NULL) {
-            fprintf(csv_file, "C,%d,%.6f,%.6f,%.6f,%.2f,%d,%.3f\n",
-                    n,
-                    avg_time * 1000,  // Convert to ms
-                    min_time * 1000,
-                    max_time * 1000,
-                    mem_kb / 1024.0,
-                    iterations,
-                    gflops);
-        }
 
-        printf("\n");
+        for (int impl = 0; impl < IMPL_COUNT; impl++) {
+            double avg_time, min_time, max_time, gflops;
+            long mem_kb;
+
+            // Run benchmark and capture results
+            run_benchmark_with_results(n, iterations, (Implementation)impl, &avg_time, &min_time,
+                                       &max_time, &mem_kb, &gflops);
+
+            // Write to CSV; variants are tagged in the language column so the schema is unchanged
+            if (csv_file != NULL) {
+                fprintf(csv_file, "%s,%d,%.6f,%.6f,%.6f,%.2f,%d,%.3f\n",
+                        impl_labels[impl],
+                        n,
+                        avg_time * 1000,  // Convert to ms
+                        min_time * 1000,
+                        max_time * 1000,
+                        mem_kb / 1024.0,
+                        iterations,
+                        gflops);
+            }
+
+            printf("\n");
+        }
     }
 
     if (csv_file != NULL) {
@@ -1,5 +1,7 @@
+#define _POSIX_C_SOURCE 200112L
 #include "matrix_c.h"
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 void matrix_multiply(double** a, double** b, double** c, int n) {
@@ -45,3 +47,102 @@ void initialize_zero_matrix(double** matrix, int n) {
         }
     }
 }
+
+AlignedMatrix create_aligned_matrix(int n) {
+    AlignedMatrix m;
+    const int per_line = MATRIX_ALIGNMENT / sizeof(double);
+    m.n = n;
+    m.stride = (n + per_line - 1) / per_line * per_line;
+    void* data = NULL;
+    if (posix_memalign(&data, MATRIX_ALIGNMENT, (size_t)n * m.stride * sizeof(double)) != 0) {
+        data = NULL;
+    }
+    m.data = (double*)data;
+    return m;
+}
+
+void free_aligned_matrix(AlignedMatrix* matrix) {
+    free(matrix->data);
+    matrix->data = NULL;
+}
+
+void initialize_random_aligned_matrix(AlignedMatrix* matrix, unsigned int seed) {
+    srand(seed);
+    for (int i = 0; i < matrix->n; i++) {
+        double* row = matrix->data + (size_t)i * matrix->stride;
+        for (int j = 0; j < matrix->n; j++) {
+            row[j] = (double)rand() / RAND_MAX;
+        }
+        for (int j = matrix->n; j < matrix->stride; j++) {
+            row[j] = 0.0;
+        }
+    }
+}
+
+void initialize_zero_aligned_matrix(AlignedMatrix* matrix) {
+    memset(matrix->data, 0, (size_t)matrix->n * matrix->stride * sizeof(double));
+}
+
+void matrix_multiply_ikj(const AlignedMatrix* a, const AlignedMatrix* b, AlignedMatrix* c) {
+    const int n = a->n;
+    initialize_zero_aligned_matrix(c);
+    for (int i = 0; i < n; i++) {
+        const double* a_row = a->data + (size_t)i * a->stride;
+        double* c_row = c->data + (size_t)i * c->stride;
+        for (int k = 0; k < n; k++) {
+            const double a_ik = a_row[k];
+            const double* b_row = b->data + (size_t)k * b->stride;
+            for (int j = 0; j < n; j++) {
+                c_row[j] += a_ik * b_row[j];
+            }
+        }
+    }
+}
+
+// Accumulates one (ii, kk, jj) block: C[ii.., jj..] += A[ii.., kk..] * B[kk.., jj..]
+static void multiply_tile(const AlignedMatrix* a, const AlignedMatrix* b, AlignedMatrix* c,
+                          int ii, int kk, int jj, int tile) {
+    const int n = a->n;
+    const int i_max = ii + tile < n ? ii + tile : n;
+    const int k_max = kk + tile < n ? kk + tile : n;
+    const int j_max = jj + tile < n ? jj + tile : n;
+    for (int i = ii; i < i_max; i++) {
+        const double* a_row = a->data + (size_t)i * a->stride;
+        double* c_row = c->data + (size_t)i * c->stride;
+        for (int k = kk; k < k_max; k++) {
+            const double a_ik = a_row[k];
+            const double* b_row = b->data + (size_t)k * b->stride;
+            for (int j = jj; j < j_max; j++) {
+                c_row[j] += a_ik * b_row[j];
+            }
+        }
+    }
+}
+
+void matrix_multiply_tiled(const AlignedMatrix* a, const AlignedMatrix* b, AlignedMatrix* c, int tile) {
+    const int n = a->n;
+    if (tile <= 0) tile = DEFAULT_TILE_SIZE;
+    initialize_zero_aligned_matrix(c);
+    for (int ii = 0; ii < n; ii += tile) {
+        for (int kk = 0; kk < n; kk += tile) {
+            for (int jj = 0; jj < n; jj += tile) {
+                multiply_tile(a, b, c, ii, kk, jj, tile);
+            }
+        }
+    }
+}
+
+void matrix_multiply_omp(const AlignedMatrix* a, const AlignedMatrix* b, AlignedMatrix* c, int tile) {
+    const int n = a->n;
+    if (tile <= 0) tile = DEFAULT_TILE_SIZE;
+    initialize_zero_aligned_matrix(c);
+    // Each thread owns whole row blocks of C, so no two threads write the same line
+    #pragma omp parallel for schedule(dynamic)
+    for (int ii = 0; ii < n; ii += tile) {
+        for (int kk = 0; kk < n; kk += tile) {
+            for (int jj = 0; jj < n; jj += tile) {
+                multiply_tile(a, b, c, ii, kk, jj, tile);
+            }
+        }
+    }
+}
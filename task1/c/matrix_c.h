@@ -1,6 +1,22 @@
 #ifndef MATRIX_C_H
 #define MATRIX_C_H
 
+#include <stddef.h>
+
+/**
+ * Contiguous n x n matrix stored row-major in a single 64-byte-aligned block.
+ * Each row starts on a cache line: stride is n rounded up to a multiple of 8 doubles.
+ * Element (i, j) lives at data[i * stride + j].
+ */
+typedef struct {
+    double* data;
+    int n;
+    int stride;
+} AlignedMatrix;
+
+#define MATRIX_ALIGNMENT 64
+#define DEFAULT_TILE_SIZE 64
+
 /**
  * Performs matrix multiplication C = A * B
  * @param a First matrix (n x n)
@@ -39,4 +55,58 @@ void initialize_random_matrix(double** matrix, int n, unsigned int seed);
  */
 void initialize_zero_matrix(double** matrix, int n);
 
+/**
+ * Allocates an n x n matrix as one aligned block (see AlignedMatrix)
+ * @param n Size of the matrix
+ * @return Matrix descriptor; data is NULL if allocation failed
+ */
+AlignedMatrix create_aligned_matrix(int n);
+
+/**
+ * Frees memory allocated by create_aligned_matrix
+ * @param matrix Pointer to the matrix descriptor
+ */
+void free_aligned_matrix(AlignedMatrix* matrix);
+
+/**
+ * Initializes an aligned matrix with random values (same sequence as initialize_random_matrix)
+ * @param matrix Pointer to the matrix
+ * @param seed Random seed for reproducibility
+ */
+void initialize_random_aligned_matrix(AlignedMatrix* matrix, unsigned int seed);
+
+/**
+ * Initializes an aligned matrix with zeros (padding included)
+ * @param matrix Pointer to the matrix
+ */
+void initialize_zero_aligned_matrix(AlignedMatrix* matrix);
+
+/**
+ * C = A * B with i-k-j loop order: the inner loop walks rows of B and C
+ * sequentially instead of striding down a column of B
+ * @param a First matrix (n x n)
+ * @param b Second matrix (n x n)
+ * @param c Result matrix (n x n)
+ */
+void matrix_multiply_ikj(const AlignedMatrix* a, const AlignedMatrix* b, AlignedMatrix* c);
+
+/**
+ * C = A * B with i-k-j order over tile x tile blocks so the working set
+ * of B and C stays in cache while a block of A is consumed
+ * @param a First matrix (n x n)
+ * @param b Second matrix (n x n)
+ * @param c Result matrix (n x n)
+ * @param tile Block size in elements (DEFAULT_TILE_SIZE if <= 0)
+ */
+void matrix_multiply_tiled(const AlignedMatrix* a, const AlignedMatrix* b, AlignedMatrix* c, int tile);
+
+/**
+ * Tiled multiplication with row blocks of C distributed over OpenMP threads
+ * @param a First matrix (n x n)
+ * @param b Second matrix (n x n)
+ * @param c Result matrix (n x n)
+ * @param tile Block size in elements (DEFAULT_TILE_SIZE if <= 0)
+ */
+void matrix_multiply_omp(const AlignedMatrix* a, const AlignedMatrix* b, AlignedMatrix* c, int tile);
+
 #endif // MATRIX_C_H
@@ -1,23 +1,151 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <filesystem>
 #include <sstream>
 #include <chrono>
 #include <omp.h>
 #include <cmath>
 #include <algorithm>
 #include <iomanip>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <stdexcept>
+#include <charconv>
+#include <utility>
+#include <random>
+#include <variant>
+#include <limits>
+#include <type_traits>
+#include <future>
+#include <functional>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <immintrin.h>
+#include "../common/cpu_dispatch.hpp"
+#include "../common/bench.hpp"
+#include "../common/memory.hpp"
+#include "../common/numa.hpp"
 
 // ==========================================
 // 1. DATA STRUCTURES
 // ==========================================
-struct CSRMatrix {
+
+// CSR is templated on the offset type (row_ptr, nnz) and the index type
+// (col_indices, rows, cols) separately, so a matrix with more than 2^31
+// nonzeros but fewer than 2^31 columns only widens row_ptr. CSRView and
+// CSRMatrix are the 32-bit configuration every other kernel works on.
+
+// Non-owning view of CSR arrays; the sparse kernels run on this so the same
+// code works on a CSRMatrix or on a memory-mapped file (MappedCSR)
+template <class Offset, class Index>
+struct BasicCSRView {
+    Index rows;
+    Index cols;
+    Offset nnz;
+    const double* values;
+    const Index* col_indices;
+    const Offset* row_ptr;
+};
+
+template <class Offset, class Index>
+struct BasicCSRMatrix {
+    Index rows;
+    Index cols;
+    Offset nnz;
+    KernelVector<double> values;
+    KernelVector<Index> col_indices;
+    KernelVector<Offset> row_ptr;
+
+    BasicCSRView<Offset, Index> view() const {
+        return { rows, cols, nnz, values.data(), col_indices.data(), row_ptr.data() };
+    }
+};
+
+using CSRView = BasicCSRView<int, int>;
+using CSRMatrix = BasicCSRMatrix<int, int>;
+using CSRMatrix64 = BasicCSRMatrix<int64_t, int>;        // > 2^31 nonzeros
+using CSRMatrix64x64 = BasicCSRMatrix<int64_t, int64_t>; // > 2^31 rows or columns too
+
+// Narrowest configuration that holds a matrix (see readMTX_narrowest)
+using AnyCSRMatrix = std::variant<CSRMatrix, CSRMatrix64, CSRMatrix64x64>;
+
+// Same matrix with other offset / index types (the caller checks they fit)
+template <class Offset, class Index, class FromOffset, class FromIndex>
+BasicCSRMatrix<Offset, Index> convert_csr(const BasicCSRView<FromOffset, FromIndex>& A) {
+    BasicCSRMatrix<Offset, Index> B;
+    B.rows = (Index)A.rows; B.cols = (Index)A.cols; B.nnz = (Offset)A.nnz;
+    B.values.assign(A.values, A.values + A.nnz);
+    B.col_indices.assign(A.col_indices, A.col_indices + A.nnz);
+    B.row_ptr.assign(A.row_ptr, A.row_ptr + A.rows + 1);
+    return B;
+}
+
+// Merge-path split of a CSR matrix into equal shares of (rows + nnz) work.
+// Part t starts at row[t] / nonzero nnz[t]; a row cut by a boundary leaves
+// its partial sum in carry[t], which is added to y[row[t+1]] after the kernel.
+// Built once per matrix and thread count, then reused on every call.
+struct MergePartition {
+    int parts = 0;
+    std::vector<int> row;
+    std::vector<int> nnz;
+    std::vector<double> carry;
+};
+
+// SELL-C-sigma (sliced ELLPACK): rows are sorted by length inside windows of
+// sigma rows, then cut into chunks of SELL_C rows. Each chunk is padded to its
+// longest row and stored column-major, so one SIMD lane handles one row.
+// Padding entries have value 0 and repeat the row's last column index.
+constexpr int SELL_C = 8;
+
+struct SellMatrix {
     int rows;
     int cols;
     int nnz;
+    int sigma;
+    int chunks;
+    std::vector<int> chunk_ptr;     // chunks + 1 offsets into values / col_indices
+    std::vector<int> chunk_width;   // padded row length of each chunk
+    std::vector<int> row_of;        // chunks * SELL_C: original row of each slot (-1 = padding row)
     std::vector<double> values;
     std::vector<int> col_indices;
-    std::vector<int> row_ptr;
+
+    // Stored entries (including padding) per real nonzero, minus one
+    double padding_overhead() const { return nnz ? (double)values.size() / nnz - 1.0 : 0.0; }
+};
+
+// Row split of a symmetric lower triangle for sym_spmv_parallel: part t owns
+// rows [row[t], row[t+1]) (equal nnz) and accumulates into a private slice of
+// partial covering the columns [lo[t], row[t+1]) its rows can write to.
+struct SymPartition {
+    int parts = 0;
+    std::vector<int> row;
+    std::vector<int> lo;
+    std::vector<size_t> offset;   // parts + 1 slice offsets into partial
+    std::vector<double> partial;
+};
+
+// Block CSR: the matrix cut into r x c blocks; every block with at least one
+// nonzero is stored densely (row-major, explicit zeros as fill), with one
+// column index per block instead of per nonzero
+struct BCSRMatrix {
+    int rows;
+    int cols;
+    int nnz;                        // nonzeros of the source matrix
+    int r, c;
+    int block_rows;                 // ceil(rows / r)
+    std::vector<int> block_row_ptr; // block_rows + 1
+    std::vector<int> block_col;     // first column / c of each block
+    std::vector<double> values;     // r * c per block
+
+    int blocks() const { return (int)block_col.size(); }
+    // Stored entries per real nonzero (1 = no fill)
+    double fill_ratio() const { return nnz ? (double)values.size() / nnz : 1.0; }
 };
 
 // Helper for sorting raw .mtx data
@@ -33,14 +161,93 @@ struct Triplet {
 // ==========================================
 // 2. PARSER (Safe Version)
 // ==========================================
+// Read-only private mapping of a whole file (RAII, movable)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Could not open file " + filename);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("Could not stat " + filename);
+        }
+        size_ = st.st_size;
+        if (size_ > 0) {
+            void* base = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (base == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Could not mmap " + filename);
+            }
+            data_ = static_cast<const char*>(base);
+        }
+        close(fd);
+    }
+
+    MappedFile(MappedFile&& other) noexcept : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    ~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+
+    void advise(int advice) const {
+        if (data_) madvise(const_cast<char*>(data_), size_, advice);
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Format qualifiers of the "%%MatrixMarket matrix coordinate <field> <symmetry>" banner
+enum class MTXSymmetry { General, Symmetric, SkewSymmetric };
+
+struct MTXHeader {
+    bool pattern = false;                       // no value column, every entry is 1
+    MTXSymmetry symmetry = MTXSymmetry::General; // only one triangle is stored in the file
+};
+
+// Files without a banner are read as "coordinate real general"
+MTXHeader parse_mtx_banner(const std::string& line, const std::string& filename) {
+    MTXHeader header;
+    if (line.rfind("%%MatrixMarket", 0) != 0) return header;
+    std::string banner = line;
+    std::transform(banner.begin(), banner.end(), banner.begin(), [](unsigned char ch) { return std::tolower(ch); });
+    std::istringstream ss(banner);
+    std::string tag, object, format, field, symmetry;
+    ss >> tag >> object >> format >> field >> symmetry;
+    if (object != "matrix" || format != "coordinate")
+        throw std::runtime_error(filename + ": only 'matrix coordinate' files are supported");
+    if (field == "pattern") header.pattern = true;
+    else if (field != "real" && field != "integer" && field != "double")
+        throw std::runtime_error(filename + ": unsupported field '" + field + "'");
+    if (symmetry == "symmetric" || symmetry == "hermitian") header.symmetry = MTXSymmetry::Symmetric;
+    else if (symmetry == "skew-symmetric") header.symmetry = MTXSymmetry::SkewSymmetric;
+    else if (!symmetry.empty() && symmetry != "general")
+        throw std::runtime_error(filename + ": unsupported symmetry '" + symmetry + "'");
+    return header;
+}
+
 CSRMatrix readMTX(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
-        exit(1);
+        throw std::runtime_error("Could not open file " + filename);
     }
     std::string line;
+    MTXHeader header;
+    bool first = true;
     while (std::getline(file, line)) {
+        if (first) header = parse_mtx_banner(line, filename);
+        first = false;
         if (line.empty()) continue;
         if (line[0] != '%') break;
     }
@@ -49,14 +256,17 @@ CSRMatrix readMTX(const std::string& filename) {
     ss >> M >> N >> L;
     
     std::vector<Triplet> triplets;
-    triplets.reserve(L);
+    triplets.reserve(header.symmetry == MTXSymmetry::General ? L : 2 * (size_t)L);
     int r, c;
-    double v;
-    while (file >> r >> c >> v) {
+    double v = 1.0;
+    while (file >> r >> c && (header.pattern || file >> v)) {
         int row_idx = r - 1;
         int col_idx = c - 1;
         if (row_idx >= M || col_idx >= N || row_idx < 0 || col_idx < 0) continue;
         triplets.push_back({row_idx, col_idx, v});
+        // Symmetric files store one triangle: add the mirrored entry
+        if (header.symmetry != MTXSymmetry::General && row_idx != col_idx && col_idx < M && row_idx < N)
+            triplets.push_back({col_idx, row_idx, header.symmetry == MTXSymmetry::SkewSymmetric ? -v : v});
     }
     std::sort(triplets.begin(), triplets.end());
 
@@ -84,6 +294,565 @@ CSRMatrix readMTX(const std::string& filename) {
     return mat;
 }
 
+// Parallel parser: mmap the file, split the entry lines into one line-aligned
+// chunk per thread, and parse with std::from_chars. CSR is built without a
+// triplet copy or a global sort: pass 1 counts entries per row into one shared
+// histogram (atomic increments), a prefix sum turns it into row_ptr and a
+// per-row write cursor, and pass 2 parses again and claims slots from the
+// cursor to scatter straight into col_indices/values. Extra memory is one
+// Offset per row whatever the thread count. Threads fill a row in arbitrary
+// order, so each row is then sorted by (column, value) unless its columns are
+// already strictly increasing, which keeps the result deterministic.
+static inline const char* skip_blanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    return p;
+}
+
+static inline const char* next_line(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return eol ? eol + 1 : end;
+}
+
+// Parses "r c v" (or "r c" for pattern files, v = 1) at p (1-based indices).
+// Returns false for blank, comment or malformed lines.
+static inline bool parse_entry(const char* p, const char* eol, bool pattern, long long& r, long long& c, double& v) {
+    p = skip_blanks(p, eol);
+    auto res = std::from_chars(p, eol, r);
+    if (res.ec != std::errc()) return false;
+    res = std::from_chars(skip_blanks(res.ptr, eol), eol, c);
+    if (res.ec != std::errc()) return false;
+    if (pattern) {
+        v = 1.0;
+        return true;
+    }
+    res = std::from_chars(skip_blanks(res.ptr, eol), eol, v);
+    return res.ec == std::errc();
+}
+
+// Reads the banner, comments and the "M N L" size line; returns the first data line
+static const char* read_mtx_preamble(const char* p, const char* end, const std::string& filename,
+                                     MTXHeader& header, long long& M, long long& N, long long& L) {
+    header = parse_mtx_banner(std::string(p, next_line(p, end)), filename);
+    M = N = L = 0;
+    while (p < end) {
+        const char* eol = next_line(p, end);
+        const char* q = skip_blanks(p, eol);
+        p = eol;
+        if (q < eol && *q != '%' && *q != '\n') {
+            std::istringstream ss(std::string(q, eol));
+            ss >> M >> N >> L;
+            break;
+        }
+    }
+    if (M <= 0 || N <= 0) throw std::runtime_error("Missing size line in " + filename);
+    return p;
+}
+
+// Symmetric and skew-symmetric files are expanded to the full matrix. With
+// lower_triangle the file must be symmetric and only its stored triangle is
+// kept, folded below the diagonal (the input of sym_spmv). Throws
+// std::overflow_error if the matrix does not fit Offset / Index.
+template <class Offset, class Index>
+BasicCSRMatrix<Offset, Index> readMTX_parallel_as(const std::string& filename, bool lower_triangle = false) {
+    MappedFile file(filename);
+    file.advise(MADV_SEQUENTIAL);
+    const char* end = file.data() + file.size();
+
+    MTXHeader header;
+    long long M, N, L;
+    const char* p = read_mtx_preamble(file.data(), end, filename, header, M, N, L);
+    if (M > std::numeric_limits<Index>::max() || N > std::numeric_limits<Index>::max())
+        throw std::overflow_error(filename + ": dimensions do not fit the index type");
+    if (lower_triangle && header.symmetry != MTXSymmetry::Symmetric)
+        throw std::runtime_error(filename + " is not a symmetric matrix");
+    const bool mirror = header.symmetry != MTXSymmetry::General && !lower_triangle;
+    const double mirror_sign = header.symmetry == MTXSymmetry::SkewSymmetric ? -1.0 : 1.0;
+
+    const int T = omp_get_max_threads();
+    std::vector<const char*> bounds(T + 1);
+    bounds[0] = p;
+    bounds[T] = end;
+    for (int t = 1; t < T; t++) {
+        const char* guess = p + (end - p) * t / T;
+        bounds[t] = guess <= bounds[t - 1] ? bounds[t - 1] : next_line(guess - 1, end);
+    }
+
+    auto for_each_entry = [&](int t, auto&& fn) {
+        long long r, c;
+        double v;
+        for (const char* line = bounds[t]; line < bounds[t + 1];) {
+            const char* eol = next_line(line, end);
+            if (parse_entry(line, eol, header.pattern, r, c, v) && r >= 1 && r <= M && c >= 1 && c <= N) {
+                if (lower_triangle && c > r) std::swap(r, c);
+                fn((Index)(r - 1), (Index)(c - 1), v);
+                if (mirror && r != c && c <= M && r <= N) fn((Index)(c - 1), (Index)(r - 1), mirror_sign * v);
+            }
+            line = eol;
+        }
+    };
+
+    // Pass 1: shared row histogram
+    BasicCSRMatrix<Offset, Index> mat;
+    mat.rows = (Index)M; mat.cols = (Index)N;
+    mat.row_ptr.assign(M + 1, 0);
+    #pragma omp parallel num_threads(T)
+    for (int t = omp_get_thread_num(); t < T; t += omp_get_num_threads()) {
+        for_each_entry(t, [&](Index r, Index, double) {
+            #pragma omp atomic
+            mat.row_ptr[r + 1]++;
+        });
+    }
+    for (Index i = 0; i < mat.rows; i++) {
+        if (mat.row_ptr[i + 1] > std::numeric_limits<Offset>::max() - mat.row_ptr[i])
+            throw std::overflow_error(filename + ": nonzeros do not fit the offset type");
+        mat.row_ptr[i + 1] += mat.row_ptr[i];
+    }
+    mat.nnz = mat.row_ptr[M];
+
+    // Pass 2: scatter, each entry claiming the next free slot of its row
+    std::vector<Offset> cursor(mat.row_ptr.begin(), mat.row_ptr.end() - 1);
+    mat.col_indices.resize(mat.nnz);
+    mat.values.resize(mat.nnz);
+    #pragma omp parallel num_threads(T)
+    for (int t = omp_get_thread_num(); t < T; t += omp_get_num_threads()) {
+        for_each_entry(t, [&](Index r, Index c, double v) {
+            Offset pos;
+            #pragma omp atomic capture
+            pos = cursor[r]++;
+            mat.col_indices[pos] = c;
+            mat.values[pos] = v;
+        });
+    }
+    std::vector<Offset>().swap(cursor);
+
+    // Sort rows whose columns are not strictly increasing; duplicates are
+    // ordered by value so the layout does not depend on thread timing
+    #pragma omp parallel
+    {
+        std::vector<std::pair<Index, double>> row;
+        #pragma omp for schedule(dynamic, 1024)
+        for (Index i = 0; i < mat.rows; i++) {
+            auto first = mat.col_indices.begin() + mat.row_ptr[i], last = mat.col_indices.begin() + mat.row_ptr[i + 1];
+            if (std::adjacent_find(first, last, std::greater_equal<Index>()) == last) continue;
+            Offset begin = mat.row_ptr[i], end_k = mat.row_ptr[i + 1];
+            row.clear();
+            for (Offset k = begin; k < end_k; k++) row.emplace_back(mat.col_indices[k], mat.values[k]);
+            std::sort(row.begin(), row.end());
+            for (Offset k = begin; k < end_k; k++) {
+                mat.col_indices[k] = row[k - begin].first;
+                mat.values[k] = row[k - begin].second;
+            }
+        }
+    }
+    return mat;
+}
+
+CSRMatrix readMTX_parallel(const std::string& filename, bool lower_triangle = false) {
+    return readMTX_parallel_as<int, int>(filename, lower_triangle);
+}
+
+// Picks the narrowest offset / index types from the size line (symmetric files
+// count twice, as the upper bound after expansion)
+AnyCSRMatrix readMTX_narrowest(const std::string& filename) {
+    MTXHeader header;
+    long long M, N, L;
+    {
+        MappedFile file(filename);
+        read_mtx_preamble(file.data(), file.data() + file.size(), filename, header, M, N, L);
+    }
+    const long long max_nnz = header.symmetry == MTXSymmetry::General ? L : 2 * L;
+    const long long int_max = std::numeric_limits<int>::max();
+    if (M > int_max || N > int_max) return readMTX_parallel_as<int64_t, int64_t>(filename);
+    if (max_nnz > int_max) return readMTX_parallel_as<int64_t, int>(filename);
+    return readMTX_parallel_as<int, int>(filename);
+}
+
+// ==========================================
+// 2b. BINARY CSR CACHE (mmap)
+// ==========================================
+// Layout: CSRFileHeader, then row_ptr, col_indices and values, each starting
+// on a 64-byte boundary. The loader maps the file read-only and points a
+// CSRView straight at the arrays, so no parsing or copying happens.
+constexpr char CSR_FILE_MAGIC[8] = { 'C', 'S', 'R', 'B', 'I', 'N', '\0', '\0' };
+constexpr uint32_t CSR_FILE_VERSION = 2;  // 2: symmetric/pattern files are expanded
+
+struct CSRFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t index_bytes;      // width of row_ptr / col_indices entries
+    int64_t rows;
+    int64_t cols;
+    int64_t nnz;
+    uint64_t checksum;         // csr_checksum over the three arrays
+    uint64_t row_ptr_offset;   // byte offsets from the start of the file
+    uint64_t col_indices_offset;
+    uint64_t values_offset;
+};
+
+static uint64_t align64(uint64_t offset) { return (offset + 63) & ~uint64_t(63); }
+
+// 64-bit FNV-1a style hash, one 8-byte word per step (tail bytes zero-padded)
+static uint64_t checksum_bytes(const void* data, size_t bytes, uint64_t h) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        h = (h ^ word) * 0x100000001b3ULL;
+    }
+    if (i < bytes) {
+        uint64_t word = 0;
+        std::memcpy(&word, p + i, bytes - i);
+        h = (h ^ word) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t csr_checksum(const CSRView& A) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    h = checksum_bytes(A.row_ptr, sizeof(int) * ((size_t)A.rows + 1), h);
+    h = checksum_bytes(A.col_indices, sizeof(int) * (size_t)A.nnz, h);
+    h = checksum_bytes(A.values, sizeof(double) * (size_t)A.nnz, h);
+    return h;
+}
+
+void write_csr_binary(const CSRMatrix& A, const std::string& filename) {
+    CSRFileHeader header = {};
+    std::memcpy(header.magic, CSR_FILE_MAGIC, sizeof(header.magic));
+    header.version = CSR_FILE_VERSION;
+    header.index_bytes = sizeof(int);
+    header.rows = A.rows;
+    header.cols = A.cols;
+    header.nnz = A.nnz;
+    header.checksum = csr_checksum(A.view());
+    header.row_ptr_offset = align64(sizeof(CSRFileHeader));
+    header.col_indices_offset = align64(header.row_ptr_offset + sizeof(int) * ((uint64_t)A.rows + 1));
+    header.values_offset = align64(header.col_indices_offset + sizeof(int) * (uint64_t)A.nnz);
+
+    // Write to a temporary name and rename, so a crash never leaves a truncated cache behind
+    std::string tmp = filename + ".tmp";
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) throw std::runtime_error("Could not create " + tmp);
+    auto write_at = [&](uint64_t offset, const void* data, size_t bytes) {
+        static const char zeros[64] = {};
+        uint64_t pos = (uint64_t)out.tellp();
+        out.write(zeros, offset - pos);
+        out.write(static_cast<const char*>(data), bytes);
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_at(header.row_ptr_offset, A.row_ptr.data(), sizeof(int) * ((size_t)A.rows + 1));
+    write_at(header.col_indices_offset, A.col_indices.data(), sizeof(int) * (size_t)A.nnz);
+    write_at(header.values_offset, A.values.data(), sizeof(double) * (size_t)A.nnz);
+    out.close();
+    if (!out || std::rename(tmp.c_str(), filename.c_str()) != 0)
+        throw std::runtime_error("Could not write " + filename);
+}
+
+// Empty if h describes a readable file of size bytes, otherwise the reason it does not
+static std::string csr_header_error(const CSRFileHeader& h, uint64_t size) {
+    if (std::memcmp(h.magic, CSR_FILE_MAGIC, sizeof(h.magic)) != 0) return "bad magic";
+    if (h.version != CSR_FILE_VERSION) return "unsupported version " + std::to_string(h.version);
+    if (h.index_bytes != sizeof(int)) return "unsupported index width " + std::to_string(h.index_bytes);
+    if (h.rows < 0 || h.cols < 0 || h.nnz < 0 || h.rows > INT32_MAX || h.cols > INT32_MAX || h.nnz > INT32_MAX)
+        return "dimensions out of range";
+    if (h.values_offset + sizeof(double) * (uint64_t)h.nnz > size ||
+        h.col_indices_offset + sizeof(int) * (uint64_t)h.nnz > size ||
+        h.row_ptr_offset + sizeof(int) * ((uint64_t)h.rows + 1) > size)
+        return "truncated file";
+    return "";
+}
+
+void convert_mtx_to_csr_binary(const std::string& mtx_filename, const std::string& bin_filename) {
+    write_csr_binary(readMTX_parallel(mtx_filename), bin_filename);
+}
+
+// Read-only mapping of a binary CSR file. view() points into the mapped pages
+// and stays valid for the lifetime of this object.
+class MappedCSR {
+public:
+    explicit MappedCSR(const std::string& filename, bool verify_checksum = true) : file_(filename) {
+        if (file_.size() < sizeof(CSRFileHeader))
+            throw std::runtime_error(filename + " is too small to be a CSR file");
+
+        const char* bytes = file_.data();
+        CSRFileHeader h;
+        std::memcpy(&h, bytes, sizeof(h));
+        std::string error = csr_header_error(h, file_.size());
+        if (error.empty()) {
+            view_ = { (int)h.rows, (int)h.cols, (int)h.nnz,
+                      reinterpret_cast<const double*>(bytes + h.values_offset),
+                      reinterpret_cast<const int*>(bytes + h.col_indices_offset),
+                      reinterpret_cast<const int*>(bytes + h.row_ptr_offset) };
+            if (verify_checksum && csr_checksum(view_) != h.checksum) error = "checksum mismatch";
+        }
+        if (!error.empty()) throw std::runtime_error(filename + ": " + error);
+        file_.advise(MADV_WILLNEED);
+    }
+
+    const CSRView& view() const { return view_; }
+
+private:
+    MappedFile file_;
+    CSRView view_ = {};
+};
+
+// Maps <mtx_filename minus .mtx>.csrbin, converting the text file first if the
+// cache is missing, older than the .mtx, or fails validation
+MappedCSR load_csr_cached(const std::string& mtx_filename) {
+    std::string bin_filename = mtx_filename;
+    if (bin_filename.size() > 4 && bin_filename.compare(bin_filename.size() - 4, 4, ".mtx") == 0)
+        bin_filename.resize(bin_filename.size() - 4);
+    bin_filename += ".csrbin";
+
+    struct stat mtx_st, bin_st;
+    bool have_mtx = stat(mtx_filename.c_str(), &mtx_st) == 0;
+    bool have_bin = stat(bin_filename.c_str(), &bin_st) == 0;
+    if (have_bin && (!have_mtx || bin_st.st_mtime >= mtx_st.st_mtime)) {
+        try {
+            return MappedCSR(bin_filename);
+        } catch (const std::exception& e) {
+            std::cerr << "  Ignoring CSR cache (" << e.what() << "), rebuilding." << std::endl;
+        }
+    }
+    if (!have_mtx) throw std::runtime_error("Could not open file " + mtx_filename);
+    std::cout << "  Converting " << mtx_filename << " -> " << bin_filename << std::endl;
+    convert_mtx_to_csr_binary(mtx_filename, bin_filename);
+    return MappedCSR(bin_filename);
+}
+
+// ==========================================
+// 2c. REORDERING (locality of x)
+// ==========================================
+// Orderings are permutations with perm[new] = old. permute_csr applies one
+// symmetrically (B = P A P^T), so B works on permute_vector(x) and its result
+// goes back to the original numbering with unpermute_vector.
+
+// Symmetrized pattern A + A^T without self loops, as adjacency lists
+static void symmetric_pattern(const CSRView& A, std::vector<int>& adj_ptr, std::vector<int>& adj) {
+    const int n = A.rows;
+    adj_ptr.assign(n + 1, 0);
+    for (int i = 0; i < n; i++)
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) {
+            int j = A.col_indices[k];
+            if (j == i) continue;
+            adj_ptr[i + 1]++;
+            adj_ptr[j + 1]++;
+        }
+    for (int i = 0; i < n; i++) adj_ptr[i + 1] += adj_ptr[i];
+    adj.resize(adj_ptr[n]);
+    std::vector<int> fill(adj_ptr.begin(), adj_ptr.end() - 1);
+    for (int i = 0; i < n; i++)
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) {
+            int j = A.col_indices[k];
+            if (j == i) continue;
+            adj[fill[i]++] = j;
+            adj[fill[j]++] = i;
+        }
+    // Drop the duplicates that symmetric entries produce
+    int out = 0;
+    for (int i = 0; i < n; i++) {
+        int begin = adj_ptr[i], end = adj_ptr[i + 1];
+        std::sort(adj.begin() + begin, adj.begin() + end);
+        adj_ptr[i] = out;
+        for (int k = begin; k < end; k++)
+            if (k == begin || adj[k] != adj[k - 1]) adj[out++] = adj[k];
+    }
+    adj_ptr[n] = out;
+    adj.resize(out);
+}
+
+static void require_square(const CSRView& A, const char* what) {
+    if (A.rows != A.cols) throw std::runtime_error(std::string(what) + " needs a square matrix");
+}
+
+// Reverse Cuthill-McKee: BFS from a pseudo-peripheral node of each connected
+// component, visiting neighbours by increasing degree, then reversed
+std::vector<int> rcm_ordering(const CSRView& A) {
+    require_square(A, "rcm_ordering");
+    const int n = A.rows;
+    std::vector<int> adj_ptr, adj;
+    symmetric_pattern(A, adj_ptr, adj);
+    auto degree = [&](int v) { return adj_ptr[v + 1] - adj_ptr[v]; };
+
+    std::vector<int> level(n, -1), order, queue, next;
+    order.reserve(n);
+    std::vector<char> visited(n, 0);
+
+    // BFS over the component of root: returns its depth, leaves the visit order
+    // in queue and the start of the deepest level in last_start
+    size_t last_start = 0;
+    auto bfs_levels = [&](int root) {
+        queue.assign(1, root);
+        level[root] = 0;
+        for (size_t h = 0; h < queue.size(); h++) {
+            int u = queue[h];
+            for (int k = adj_ptr[u]; k < adj_ptr[u + 1]; k++)
+                if (level[adj[k]] < 0) {
+                    level[adj[k]] = level[u] + 1;
+                    queue.push_back(adj[k]);
+                }
+        }
+        int depth = level[queue.back()];
+        last_start = queue.size();
+        while (last_start > 0 && level[queue[last_start - 1]] == depth) last_start--;
+        for (int v : queue) level[v] = -1;
+        return depth;
+    };
+
+    // Seeds in increasing degree order (counting sort)
+    int max_degree = 0;
+    for (int v = 0; v < n; v++) max_degree = std::max(max_degree, degree(v));
+    std::vector<int> seed_ptr(max_degree + 2, 0), seeds(n);
+    for (int v = 0; v < n; v++) seed_ptr[degree(v) + 1]++;
+    for (int d = 0; d <= max_degree; d++) seed_ptr[d + 1] += seed_ptr[d];
+    for (int v = 0; v < n; v++) seeds[seed_ptr[degree(v)]++] = v;
+
+    for (int seed : seeds) {
+        if (visited[seed]) continue;
+
+        // George-Liu: restart from the min-degree node of the deepest level while the depth grows
+        int root = seed, depth = bfs_levels(root);
+        for (;;) {
+            int candidate = queue[last_start];
+            for (size_t h = last_start; h < queue.size(); h++)
+                if (degree(queue[h]) < degree(candidate)) candidate = queue[h];
+            int candidate_depth = bfs_levels(candidate);
+            if (candidate_depth <= depth) break;
+            root = candidate;
+            depth = candidate_depth;
+        }
+
+        // Cuthill-McKee BFS from root
+        size_t head = order.size();
+        order.push_back(root);
+        visited[root] = 1;
+        for (; head < order.size(); head++) {
+            int u = order[head];
+            next.clear();
+            for (int k = adj_ptr[u]; k < adj_ptr[u + 1]; k++)
+                if (!visited[adj[k]]) {
+                    visited[adj[k]] = 1;
+                    next.push_back(adj[k]);
+                }
+            std::sort(next.begin(), next.end(), [&](int a, int b) { return degree(a) < degree(b); });
+            order.insert(order.end(), next.begin(), next.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Greedy graph growing: each part is grown by BFS from an unassigned seed
+// until it holds part_rows rows and is numbered contiguously, so a part's rows
+// share most of their x entries. The next seed is the first unassigned
+// neighbour reached from the previous part, keeping consecutive parts adjacent.
+std::vector<int> partition_ordering(const CSRView& A, int part_rows) {
+    require_square(A, "partition_ordering");
+    const int n = A.rows;
+    part_rows = std::max(1, part_rows);
+    std::vector<int> adj_ptr, adj;
+    symmetric_pattern(A, adj_ptr, adj);
+
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> assigned(n, 0);
+    std::vector<int> frontier;
+    int scan = 0;   // lowest row that may still be unassigned
+    while ((int)order.size() < n) {
+        int seed = -1;
+        for (int v : frontier)
+            if (!assigned[v]) { seed = v; break; }
+        if (seed < 0) {
+            while (assigned[scan]) scan++;
+            seed = scan;
+        }
+
+        size_t head = order.size(), part_end = std::min<size_t>(n, order.size() + part_rows);
+        order.push_back(seed);
+        assigned[seed] = 1;
+        frontier.clear();
+        for (; head < order.size(); head++) {
+            int u = order[head];
+            for (int k = adj_ptr[u]; k < adj_ptr[u + 1]; k++) {
+                int v = adj[k];
+                if (assigned[v]) continue;
+                if (order.size() < part_end) {
+                    assigned[v] = 1;
+                    order.push_back(v);
+                } else {
+                    frontier.push_back(v);
+                }
+            }
+        }
+    }
+    return order;
+}
+
+// B = P A P^T: row r of B is row perm[r] of A with renumbered, sorted columns
+CSRMatrix permute_csr(const CSRView& A, const std::vector<int>& perm) {
+    require_square(A, "permute_csr");
+    const int n = A.rows;
+    std::vector<int> inverse(n);
+    for (int r = 0; r < n; r++) inverse[perm[r]] = r;
+
+    CSRMatrix B;
+    B.rows = n; B.cols = n; B.nnz = A.nnz;
+    B.row_ptr.assign(n + 1, 0);
+    for (int r = 0; r < n; r++) B.row_ptr[r + 1] = B.row_ptr[r] + (A.row_ptr[perm[r] + 1] - A.row_ptr[perm[r]]);
+    B.col_indices.resize(A.nnz);
+    B.values.resize(A.nnz);
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, double>> row;
+        #pragma omp for schedule(dynamic, 1024)
+        for (int r = 0; r < n; r++) {
+            int old = perm[r];
+            row.clear();
+            for (int k = A.row_ptr[old]; k < A.row_ptr[old + 1]; k++)
+                row.emplace_back(inverse[A.col_indices[k]], A.values[k]);
+            std::sort(row.begin(), row.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (size_t k = 0; k < row.size(); k++) {
+                B.col_indices[B.row_ptr[r] + k] = row[k].first;
+                B.values[B.row_ptr[r] + k] = row[k].second;
+            }
+        }
+    }
+    return B;
+}
+
+// x in the original numbering -> x in the permuted numbering
+std::vector<double> permute_vector(const std::vector<double>& x, const std::vector<int>& perm) {
+    std::vector<double> xp(perm.size());
+    for (size_t r = 0; r < perm.size(); r++) xp[r] = x[perm[r]];
+    return xp;
+}
+
+// y in the permuted numbering -> y in the original numbering
+std::vector<double> unpermute_vector(const std::vector<double>& yp, const std::vector<int>& perm) {
+    std::vector<double> y(perm.size());
+    for (size_t r = 0; r < perm.size(); r++) y[perm[r]] = yp[r];
+    return y;
+}
+
+// Bandwidth: max |i - j| over the nonzeros. Profile: sum over rows of the
+// row's farthest nonzero from the diagonal (envelope size, either side).
+struct BandwidthStats {
+    long long bandwidth;
+    long long profile;
+};
+
+BandwidthStats bandwidth_stats(const CSRView& A) {
+    long long bandwidth = 0, profile = 0;
+    #pragma omp parallel for reduction(max:bandwidth) reduction(+:profile)
+    for (int i = 0; i < A.rows; i++) {
+        long long width = 0;
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) width = std::max<long long>(width, std::abs(i - A.col_indices[k]));
+        bandwidth = std::max(bandwidth, width);
+        profile += width;
+    }
+    return { bandwidth, profile };
+}
+
 // ==========================================
 // 3. ALGORITHMS
 // ==========================================
@@ -91,9 +860,10 @@ CSRMatrix readMTX(const std::string& filename) {
 // 1. Naive Dense (Baseline)
 void dense_spmv_naive(const std::vector<double>& A, const std::vector<double>& x, std::vector<double>& y, int rows, int cols) {
     for (int i = 0; i < rows; i++) {
+        const double* row = &A[(size_t)i * cols];
         double sum = 0.0;
         for (int j = 0; j < cols; j++) {
-            sum += A[i * cols + j] * x[j];
+            sum += row[j] * x[j];
         }
         y[i] = sum;
     }
@@ -102,47 +872,1100 @@ void dense_spmv_naive(const std::vector<double>& A, const std::vector<double>& x
 // 2. Optimized Dense (Unrolling)
 void dense_spmv_optimized(const std::vector<double>& A, const std::vector<double>& x, std::vector<double>& y, int rows, int cols) {
     for (int i = 0; i < rows; i++) {
+        const double* row = &A[(size_t)i * cols];
         double sum = 0.0;
         int j = 0;
         for (; j <= cols - 4; j += 4) {
-            sum += A[i * cols + j] * x[j];
-            sum += A[i * cols + j+1] * x[j+1];
-            sum += A[i * cols + j+2] * x[j+2];
-            sum += A[i * cols + j+3] * x[j+3];
+            sum += row[j] * x[j];
+            sum += row[j+1] * x[j+1];
+            sum += row[j+2] * x[j+2];
+            sum += row[j+3] * x[j+3];
         }
         for (; j < cols; j++) {
-            sum += A[i * cols + j] * x[j];
+            sum += row[j] * x[j];
         }
         y[i] = sum;
     }
 }
 
-// 3. Sparse CSR
-void csr_spmv(const CSRMatrix& A, const std::vector<double>& x, std::vector<double>& y) {
+// Diagonal d of the merge path walks rows (row_ptr[1..]) against nonzeros
+// (0..nnz); its crossing point is the largest i with row_ptr[i] <= d - i.
+MergePartition merge_path_partition(const CSRView& A, int parts) {
+    MergePartition P;
+    P.parts = parts;
+    P.row.resize(parts + 1);
+    P.nnz.resize(parts + 1);
+    P.carry.assign(parts, 0.0);
+    const long long total = (long long)A.rows + A.nnz;
+    for (int t = 0; t <= parts; t++) {
+        long long d = total * t / parts;
+        int lo = (int)std::max(0LL, d - A.nnz), hi = (int)std::min<long long>(d, A.rows);
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (A.row_ptr[mid + 1] <= d - 1 - mid) lo = mid + 1;
+            else hi = mid;
+        }
+        P.row[t] = lo;
+        P.nnz[t] = (int)(d - lo);
+    }
+    return P;
+}
+
+SellMatrix csr_to_sell(const CSRView& A, int sigma) {
+    SellMatrix S;
+    S.rows = A.rows; S.cols = A.cols; S.nnz = A.nnz;
+    S.sigma = std::max(1, sigma);
+    S.chunks = (A.rows + SELL_C - 1) / SELL_C;
+    S.row_of.assign((size_t)S.chunks * SELL_C, -1);
+    for (int i = 0; i < A.rows; i++) S.row_of[i] = i;
+
+    auto length = [&](int i) { return A.row_ptr[i+1] - A.row_ptr[i]; };
+    for (int w = 0; w < A.rows; w += S.sigma) {
+        int w_end = std::min(A.rows, w + S.sigma);
+        std::stable_sort(S.row_of.begin() + w, S.row_of.begin() + w_end,
+                         [&](int a, int b) { return length(a) > length(b); });
+    }
+
+    S.chunk_ptr.assign(S.chunks + 1, 0);
+    S.chunk_width.assign(S.chunks, 0);
+    for (int c = 0; c < S.chunks; c++) {
+        for (int r = 0; r < SELL_C; r++) {
+            int i = S.row_of[c * SELL_C + r];
+            if (i >= 0) S.chunk_width[c] = std::max(S.chunk_width[c], length(i));
+        }
+        S.chunk_ptr[c+1] = S.chunk_ptr[c] + S.chunk_width[c] * SELL_C;
+    }
+
+    S.values.assign(S.chunk_ptr[S.chunks], 0.0);
+    S.col_indices.assign(S.chunk_ptr[S.chunks], 0);
+    #pragma omp parallel for schedule(static)
+    for (int c = 0; c < S.chunks; c++) {
+        for (int r = 0; r < SELL_C; r++) {
+            int i = S.row_of[c * SELL_C + r];
+            int len = i >= 0 ? length(i) : 0;
+            int pad_col = len ? A.col_indices[A.row_ptr[i+1] - 1] : 0;
+            for (int j = 0; j < S.chunk_width[c]; j++) {
+                size_t slot = S.chunk_ptr[c] + (size_t)j * SELL_C + r;
+                if (j < len) {
+                    S.values[slot] = A.values[A.row_ptr[i] + j];
+                    S.col_indices[slot] = A.col_indices[A.row_ptr[i] + j];
+                } else {
+                    S.col_indices[slot] = pad_col;
+                }
+            }
+        }
+    }
+    return S;
+}
+
+// Lower triangle (diagonal included) of A, the storage used by sym_spmv
+CSRMatrix csr_lower_triangle(const CSRView& A) {
+    CSRMatrix L;
+    L.rows = A.rows; L.cols = A.cols;
+    L.row_ptr.assign(1, 0);
     for (int i = 0; i < A.rows; i++) {
-        double sum = 0.0;
         for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) {
-            sum += A.values[k] * x[A.col_indices[k]];
+            if (A.col_indices[k] > i) continue;
+            L.col_indices.push_back(A.col_indices[k]);
+            L.values.push_back(A.values[k]);
         }
-        y[i] = sum;
+        L.row_ptr.push_back((int)L.col_indices.size());
+    }
+    L.nnz = L.row_ptr[A.rows];
+    return L;
+}
+
+// Symmetric file -> lower triangle, without ever expanding it
+CSRMatrix readMTX_symmetric(const std::string& filename) {
+    return readMTX_parallel(filename, true);
+}
+
+SymPartition sym_partition(const CSRView& L, int parts) {
+    SymPartition P;
+    P.parts = parts;
+    P.row.resize(parts + 1);
+    P.lo.resize(parts);
+    P.offset.assign(parts + 1, 0);
+    for (int t = 0; t <= parts; t++) {
+        int target = (int)((long long)L.nnz * t / parts);
+        P.row[t] = (int)(std::lower_bound(L.row_ptr, L.row_ptr + L.rows + 1, target) - L.row_ptr);
+    }
+    P.row[parts] = L.rows;
+    for (int t = 0; t < parts; t++) {
+        int lo = P.row[t];
+        for (int k = L.row_ptr[P.row[t]]; k < L.row_ptr[P.row[t+1]]; k++) lo = std::min(lo, L.col_indices[k]);
+        P.lo[t] = lo;
+        P.offset[t+1] = P.offset[t] + (P.row[t+1] - lo);
+    }
+    P.partial.resize(P.offset[parts]);
+    return P;
+}
+
+// 3. Sparse CSR / 4. Parallel Sparse CSR (OpenMP)
+// Both are compiled once per instruction set from spmv_kernels.inc (AVX2 and
+// AVX-512 gather x through col_indices) and dispatched through spmv_kernels,
+// chosen once at startup (detect_isa, or --isa=<name>).
+namespace isa_scalar {
+using V = double;
+constexpr int VW = 1;
+static inline V v_zero() { return 0.0; }
+static inline V v_load(const double* p) { return *p; }
+static inline void v_store(double* p, V v) { *p = v; }
+static inline V v_fmadd(V a, V b, V c) { return a * b + c; }
+static inline double v_hsum(V v) { return v; }
+template <class Index>
+static inline V v_gather(const double* x, const Index* idx) { return x[idx[0]]; }
+#include "spmv_kernels.inc"
+}
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+namespace isa_sse2 {
+using V = __m128d;
+constexpr int VW = 2;
+static inline V v_zero() { return _mm_setzero_pd(); }
+static inline V v_load(const double* p) { return _mm_loadu_pd(p); }
+static inline void v_store(double* p, V v) { _mm_storeu_pd(p, v); }
+static inline V v_fmadd(V a, V b, V c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+static inline double v_hsum(V v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+template <class Index>
+static inline V v_gather(const double* x, const Index* idx) { return _mm_set_pd(x[idx[1]], x[idx[0]]); }
+#include "spmv_kernels.inc"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace isa_avx2 {
+using V = __m256d;
+constexpr int VW = 4;
+static inline V v_zero() { return _mm256_setzero_pd(); }
+static inline V v_load(const double* p) { return _mm256_loadu_pd(p); }
+static inline void v_store(double* p, V v) { _mm256_storeu_pd(p, v); }
+static inline V v_fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+static inline double v_hsum(V v) {
+    __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+static inline V v_gather(const double* x, const int* idx) {
+    // Masked form with an explicit zero source (the unmasked one trips -Wmaybe-uninitialized)
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, _mm_loadu_si128((const __m128i*)idx),
+                                    _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+static inline V v_gather(const double* x, const int64_t* idx) {
+    return _mm256_mask_i64gather_pd(_mm256_setzero_pd(), x, _mm256_loadu_si256((const __m256i*)idx),
+                                    _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+#include "spmv_kernels.inc"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+namespace isa_avx512 {
+using V = __m512d;
+constexpr int VW = 8;
+static inline V v_zero() { return _mm512_setzero_pd(); }
+static inline V v_load(const double* p) { return _mm512_loadu_pd(p); }
+static inline void v_store(double* p, V v) { _mm512_storeu_pd(p, v); }
+static inline V v_fmadd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+static inline double v_hsum(V v) {
+    alignas(64) double lanes[VW];
+    _mm512_store_pd(lanes, v);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+static inline V v_gather(const double* x, const int* idx) {
+    return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, _mm256_loadu_si256((const __m256i*)idx), x, 8);
+}
+static inline V v_gather(const double* x, const int64_t* idx) {
+    return _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, _mm512_loadu_si512(idx), x, 8);
+}
+#include "spmv_kernels.inc"
+}
+#pragma GCC pop_options
+
+// The parallel kernels optionally record each thread's busy time (seconds,
+// indexed by omp thread number) in thread_time, for load-imbalance reports.
+struct SpmvKernels {
+    Isa isa;
+    void (*merge)(const CSRView& A, MergePartition& P, const double* x, double* y, double* thread_time);
+    void (*sell)(const SellMatrix& A, const double* x, double* y);
+    void (*spmm)(const CSRView& A, const double* X, double* Y, int k);
+    void (*rows_dots)(const CSRView& A, const double* x, double* y, int r0, int r1, double scale, double* xy, double* yy);
+};
+
+static SpmvKernels spmv_kernels_for(Isa isa) {
+    switch (isa) {
+        case Isa::AVX512: return { isa, isa_avx512::csr_spmv_merge, isa_avx512::sell_spmv_parallel, isa_avx512::csr_spmm,
+                                   isa_avx512::csr_spmv_rows_dots };
+        case Isa::AVX2:   return { isa, isa_avx2::csr_spmv_merge, isa_avx2::sell_spmv_parallel, isa_avx2::csr_spmm,
+                                   isa_avx2::csr_spmv_rows_dots };
+        case Isa::SSE2:   return { isa, isa_sse2::csr_spmv_merge, isa_sse2::sell_spmv_parallel, isa_sse2::csr_spmm,
+                                   isa_sse2::csr_spmv_rows_dots };
+        default:          return { isa, isa_scalar::csr_spmv_merge, isa_scalar::sell_spmv_parallel, isa_scalar::csr_spmm,
+                                   isa_scalar::csr_spmv_rows_dots };
+    }
+}
+
+// Basic CSR kernels, one instantiation per offset / index configuration
+template <class Offset, class Index>
+struct CSRKernels {
+    void (*serial)(const BasicCSRView<Offset, Index>& A, const double* x, double* y);
+    void (*parallel)(const BasicCSRView<Offset, Index>& A, const double* x, double* y, double* thread_time);
+};
+
+template <class Offset, class Index>
+static CSRKernels<Offset, Index> csr_kernels_for(Isa isa) {
+    switch (isa) {
+        case Isa::AVX512: return { isa_avx512::csr_spmv<Offset, Index>, isa_avx512::csr_spmv_parallel<Offset, Index> };
+        case Isa::AVX2:   return { isa_avx2::csr_spmv<Offset, Index>, isa_avx2::csr_spmv_parallel<Offset, Index> };
+        case Isa::SSE2:   return { isa_sse2::csr_spmv<Offset, Index>, isa_sse2::csr_spmv_parallel<Offset, Index> };
+        default:          return { isa_scalar::csr_spmv<Offset, Index>, isa_scalar::csr_spmv_parallel<Offset, Index> };
+    }
+}
+
+static SpmvKernels spmv_kernels = spmv_kernels_for(detect_isa());
+
+template <class Offset, class Index>
+void csr_spmv(const BasicCSRView<Offset, Index>& A, const std::vector<double>& x, std::vector<double>& y) {
+    csr_kernels_for<Offset, Index>(spmv_kernels.isa).serial(A, x.data(), y.data());
+}
+
+template <class Offset, class Index>
+void csr_spmv(const BasicCSRMatrix<Offset, Index>& A, const std::vector<double>& x, std::vector<double>& y) {
+    csr_spmv(A.view(), x, y);
+}
+
+template <class Offset, class Index>
+void csr_spmv_parallel(const BasicCSRView<Offset, Index>& A, const std::vector<double>& x, std::vector<double>& y,
+                       double* thread_time = nullptr) {
+    csr_kernels_for<Offset, Index>(spmv_kernels.isa).parallel(A, x.data(), y.data(), thread_time);
+}
+
+template <class Offset, class Index>
+void csr_spmv_parallel(const BasicCSRMatrix<Offset, Index>& A, const std::vector<double>& x, std::vector<double>& y) {
+    csr_spmv_parallel(A.view(), x, y);
+}
+
+// 5. Merge-path Sparse CSR: P comes from merge_path_partition(A, threads)
+void csr_spmv_merge(const CSRView& A, MergePartition& P, const std::vector<double>& x, std::vector<double>& y,
+                    double* thread_time = nullptr) {
+    spmv_kernels.merge(A, P, x.data(), y.data(), thread_time);
+}
+
+// 6. SELL-C-sigma: A comes from csr_to_sell
+void sell_spmv_parallel(const SellMatrix& A, const std::vector<double>& x, std::vector<double>& y) {
+    spmv_kernels.sell(A, x.data(), y.data());
+}
+
+// 7. Symmetric Sparse CSR: L is the lower triangle of a symmetric matrix, so
+// each off-diagonal a_ij adds a_ij * x[j] to y[i] and a_ij * x[i] to y[j]
+void sym_spmv(const CSRView& L, const std::vector<double>& x, std::vector<double>& y) {
+    std::fill(y.begin(), y.begin() + L.rows, 0.0);
+    for (int i = 0; i < L.rows; i++) {
+        double xi = x[i], sum = 0.0;
+        for (int k = L.row_ptr[i]; k < L.row_ptr[i+1]; k++) {
+            int j = L.col_indices[k];
+            double a = L.values[k];
+            sum += a * x[j];
+            if (j != i) y[j] += a * xi;
+        }
+        y[i] += sum;
     }
 }
 
-// 4. Parallel Sparse CSR (OpenMP)
-void csr_spmv_parallel(const CSRMatrix& A, const std::vector<double>& x, std::vector<double>& y) {
-    #pragma omp parallel for schedule(dynamic)
+// Parallel version: every part writes only its own slice of P.partial (from
+// sym_partition(L, threads)), and the slices covering a row are summed into y
+void sym_spmv_parallel(const CSRView& L, SymPartition& P, const std::vector<double>& x, std::vector<double>& y) {
+    if (P.parts == 1) return sym_spmv(L, x, y);
+    #pragma omp parallel
+    {
+        #pragma omp for schedule(static)
+        for (int t = 0; t < P.parts; t++) {
+            std::fill(P.partial.begin() + P.offset[t], P.partial.begin() + P.offset[t+1], 0.0);
+            double* out = P.partial.data() + P.offset[t] - P.lo[t];
+            for (int i = P.row[t]; i < P.row[t+1]; i++) {
+                double xi = x[i], sum = 0.0;
+                for (int k = L.row_ptr[i]; k < L.row_ptr[i+1]; k++) {
+                    int j = L.col_indices[k];
+                    double a = L.values[k];
+                    sum += a * x[j];
+                    if (j != i) out[j] += a * xi;
+                }
+                out[i] += sum;
+            }
+        }
+
+        // Row i can only appear in the slices of its owner and later parts
+        #pragma omp for schedule(static)
+        for (int owner = 0; owner < P.parts; owner++)
+            for (int i = P.row[owner]; i < P.row[owner+1]; i++) {
+                double sum = 0.0;
+                for (int t = owner; t < P.parts; t++)
+                    if (P.lo[t] <= i) sum += P.partial[P.offset[t] + (i - P.lo[t])];
+                y[i] = sum;
+            }
+    }
+}
+
+// 8. Sparse x dense block: X is cols x k and Y rows x k, both row-major
+void csr_spmm(const CSRView& A, const std::vector<double>& X, std::vector<double>& Y, int k) {
+    spmv_kernels.spmm(A, X.data(), Y.data(), k);
+}
+
+// 9. Sparse x Sparse (SpGEMM, Gustavson): row i of C = A * B is the sum of
+// the rows B[k, :] scaled by a_ik. The symbolic phase counts each output row
+// exactly, so C is allocated once; the numeric phase fills it. Each thread
+// keeps a dense accumulator over B's columns (marker + values) reused for all
+// its rows.
+static void require_spgemm_shapes(const CSRView& A, const CSRView& B) {
+    if (A.cols != B.rows) throw std::runtime_error("spgemm: A.cols != B.rows");
+}
+
+// Row pointers of C = A * B (exact sizes)
+KernelVector<int> spgemm_symbolic(const CSRView& A, const CSRView& B) {
+    require_spgemm_shapes(A, B);
+    KernelVector<int> row_ptr(A.rows + 1, 0);
+    #pragma omp parallel
+    {
+        std::vector<int> marker(B.cols, -1);
+        #pragma omp for schedule(dynamic, 256)
+        for (int i = 0; i < A.rows; i++) {
+            int count = 0;
+            for (int p = A.row_ptr[i]; p < A.row_ptr[i+1]; p++) {
+                int k = A.col_indices[p];
+                for (int q = B.row_ptr[k]; q < B.row_ptr[k+1]; q++) {
+                    int j = B.col_indices[q];
+                    if (marker[j] != i) {
+                        marker[j] = i;
+                        count++;
+                    }
+                }
+            }
+            row_ptr[i + 1] = count;
+        }
+    }
     for (int i = 0; i < A.rows; i++) {
+        if (row_ptr[i + 1] > INT32_MAX - row_ptr[i]) throw std::runtime_error("spgemm: result has more than 2^31 nonzeros");
+        row_ptr[i + 1] += row_ptr[i];
+    }
+    return row_ptr;
+}
+
+// Fills C, whose row_ptr came from spgemm_symbolic and whose arrays are already sized
+void spgemm_numeric(const CSRView& A, const CSRView& B, CSRMatrix& C) {
+    #pragma omp parallel
+    {
+        std::vector<int> marker(B.cols, -1);
+        std::vector<double> accumulator(B.cols);
+        #pragma omp for schedule(dynamic, 256)
+        for (int i = 0; i < A.rows; i++) {
+            int* cols = C.col_indices.data() + C.row_ptr[i];
+            int count = 0;
+            for (int p = A.row_ptr[i]; p < A.row_ptr[i+1]; p++) {
+                int k = A.col_indices[p];
+                double a = A.values[p];
+                for (int q = B.row_ptr[k]; q < B.row_ptr[k+1]; q++) {
+                    int j = B.col_indices[q];
+                    if (marker[j] != i) {
+                        marker[j] = i;
+                        accumulator[j] = a * B.values[q];
+                        cols[count++] = j;
+                    } else {
+                        accumulator[j] += a * B.values[q];
+                    }
+                }
+            }
+            std::sort(cols, cols + count);
+            double* values = C.values.data() + C.row_ptr[i];
+            for (int t = 0; t < count; t++) values[t] = accumulator[cols[t]];
+        }
+    }
+}
+
+CSRMatrix spgemm(const CSRView& A, const CSRView& B) {
+    CSRMatrix C;
+    C.rows = A.rows; C.cols = B.cols;
+    C.row_ptr = spgemm_symbolic(A, B);
+    C.nnz = C.row_ptr[A.rows];
+    C.col_indices.resize(C.nnz);
+    C.values.resize(C.nnz);
+    spgemm_numeric(A, B, C);
+    return C;
+}
+
+// Multiply-adds of A * B times two (the flop count used for GFLOPS)
+double spgemm_flops(const CSRView& A, const CSRView& B) {
+    double flops = 0;
+    #pragma omp parallel for reduction(+:flops)
+    for (int p = 0; p < A.nnz; p++) flops += B.row_ptr[A.col_indices[p] + 1] - B.row_ptr[A.col_indices[p]];
+    return 2 * flops;
+}
+
+// A^T in CSR (columns come out sorted), for A * A^T
+CSRMatrix csr_transpose(const CSRView& A) {
+    CSRMatrix T;
+    T.rows = A.cols; T.cols = A.rows; T.nnz = A.nnz;
+    T.row_ptr.assign(A.cols + 1, 0);
+    for (int p = 0; p < A.nnz; p++) T.row_ptr[A.col_indices[p] + 1]++;
+    for (int j = 0; j < A.cols; j++) T.row_ptr[j + 1] += T.row_ptr[j];
+    T.col_indices.resize(A.nnz);
+    T.values.resize(A.nnz);
+    std::vector<int> fill(T.row_ptr.begin(), T.row_ptr.end() - 1);
+    for (int i = 0; i < A.rows; i++)
+        for (int p = A.row_ptr[i]; p < A.row_ptr[i+1]; p++) {
+            int at = fill[A.col_indices[p]]++;
+            T.col_indices[at] = i;
+            T.values[at] = A.values[p];
+        }
+    return T;
+}
+
+// 10. Block CSR (register blocked)
+
+// Stored entries / nonzeros for r x c blocking, counted on every stride-th
+// block row (stride 1 = exact)
+double bcsr_fill_estimate(const CSRView& A, int r, int c, int stride = 1) {
+    const int block_rows = (A.rows + r - 1) / r;
+    std::vector<int> marker((A.cols + c - 1) / c, -1);
+    long long blocks = 0, nnz = 0;
+    for (int ib = 0; ib < block_rows; ib += stride) {
+        for (int i = ib * r; i < std::min(A.rows, (ib + 1) * r); i++)
+            for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) {
+                int jb = A.col_indices[k] / c;
+                if (marker[jb] != ib) {
+                    marker[jb] = ib;
+                    blocks++;
+                }
+                nnz++;
+            }
+    }
+    return nnz ? (double)blocks * r * c / nnz : 1.0;
+}
+
+// Candidate block shapes with a compiled kernel
+static const int BCSR_SHAPES[][2] = {
+    {1, 1}, {1, 2}, {1, 3}, {1, 4}, {2, 1}, {2, 2}, {2, 3}, {2, 4},
+    {3, 1}, {3, 2}, {3, 3}, {3, 4}, {4, 1}, {4, 2}, {4, 3}, {4, 4}
+};
+
+// Picks the shape with the least estimated matrix traffic, fill * (8 + 4 / (r * c))
+// bytes per nonzero, from a sample of about 4096 block rows
+void bcsr_choose_block(const CSRView& A, int& r, int& c) {
+    double best = 1e30;
+    r = c = 1;
+    for (const auto& shape : BCSR_SHAPES) {
+        int stride = std::max(1, A.rows / shape[0] / 4096);
+        double fill = bcsr_fill_estimate(A, shape[0], shape[1], stride);
+        double bytes = fill * (sizeof(double) + (double)sizeof(int) / (shape[0] * shape[1]));
+        if (bytes < best - 1e-9) {
+            best = bytes;
+            r = shape[0];
+            c = shape[1];
+        }
+    }
+}
+
+BCSRMatrix csr_to_bcsr(const CSRView& A, int r, int c) {
+    BCSRMatrix B;
+    B.rows = A.rows; B.cols = A.cols; B.nnz = A.nnz;
+    B.r = r; B.c = c;
+    B.block_rows = (A.rows + r - 1) / r;
+    B.block_row_ptr.assign(B.block_rows + 1, 0);
+
+    // Count, then fill: slot[jb] is the block index of block column jb in the current block row
+    std::vector<int> slot((A.cols + c - 1) / c, -1);
+    for (int ib = 0; ib < B.block_rows; ib++) {
+        int count = 0;
+        for (int i = ib * r; i < std::min(A.rows, (ib + 1) * r); i++)
+            for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) {
+                int jb = A.col_indices[k] / c;
+                if (slot[jb] != ib) {
+                    slot[jb] = ib;
+                    count++;
+                }
+            }
+        B.block_row_ptr[ib + 1] = B.block_row_ptr[ib] + count;
+    }
+    B.block_col.resize(B.block_row_ptr[B.block_rows]);
+    B.values.assign((size_t)B.blocks() * r * c, 0.0);
+
+    std::fill(slot.begin(), slot.end(), -1);
+    std::vector<int> cols_in_row;
+    for (int ib = 0; ib < B.block_rows; ib++) {
+        cols_in_row.clear();
+        for (int i = ib * r; i < std::min(A.rows, (ib + 1) * r); i++)
+            for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) {
+                int jb = A.col_indices[k] / c;
+                if (slot[jb] < 0) {
+                    slot[jb] = 0;
+                    cols_in_row.push_back(jb);
+                }
+            }
+        std::sort(cols_in_row.begin(), cols_in_row.end());
+        for (size_t b = 0; b < cols_in_row.size(); b++) {
+            B.block_col[B.block_row_ptr[ib] + b] = cols_in_row[b];
+            slot[cols_in_row[b]] = B.block_row_ptr[ib] + (int)b;
+        }
+        for (int i = ib * r; i < std::min(A.rows, (ib + 1) * r); i++)
+            for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) {
+                int j = A.col_indices[k];
+                B.values[(size_t)slot[j / c] * r * c + (i - ib * r) * c + j % c] += A.values[k];
+            }
+        for (int jb : cols_in_row) slot[jb] = -1;
+    }
+    return B;
+}
+
+BCSRMatrix csr_to_bcsr_auto(const CSRView& A) {
+    int r, c;
+    bcsr_choose_block(A, r, c);
+    return csr_to_bcsr(A, r, c);
+}
+
+// R x C blocks with the sizes known at compile time, so the R partial sums and
+// the C x values of a block stay in registers. Blocks that hang over the last
+// column or row take the bounds-checked path.
+template <int R, int C>
+static void bcsr_spmv_fixed(const BCSRMatrix& A, const double* x, double* y) {
+    const int full_block_cols = A.cols / C;
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int ib = 0; ib < A.block_rows; ib++) {
+        double acc[R] = {};
+        for (int b = A.block_row_ptr[ib]; b < A.block_row_ptr[ib + 1]; b++) {
+            const double* v = A.values.data() + (size_t)b * R * C;
+            const int jb = A.block_col[b];
+            if (jb < full_block_cols) {
+                const double* xb = x + jb * C;
+                for (int ii = 0; ii < R; ii++)
+                    for (int jj = 0; jj < C; jj++) acc[ii] += v[ii * C + jj] * xb[jj];
+            } else {
+                for (int ii = 0; ii < R; ii++)
+                    for (int jj = 0; jj < C && jb * C + jj < A.cols; jj++) acc[ii] += v[ii * C + jj] * x[jb * C + jj];
+            }
+        }
+        for (int ii = 0; ii < R && ib * R + ii < A.rows; ii++) y[ib * R + ii] = acc[ii];
+    }
+}
+
+void bcsr_spmv(const BCSRMatrix& A, const std::vector<double>& x, std::vector<double>& y) {
+    switch (A.r * 8 + A.c) {
+        case 1 * 8 + 1: return bcsr_spmv_fixed<1, 1>(A, x.data(), y.data());
+        case 1 * 8 + 2: return bcsr_spmv_fixed<1, 2>(A, x.data(), y.data());
+        case 1 * 8 + 3: return bcsr_spmv_fixed<1, 3>(A, x.data(), y.data());
+        case 1 * 8 + 4: return bcsr_spmv_fixed<1, 4>(A, x.data(), y.data());
+        case 2 * 8 + 1: return bcsr_spmv_fixed<2, 1>(A, x.data(), y.data());
+        case 2 * 8 + 2: return bcsr_spmv_fixed<2, 2>(A, x.data(), y.data());
+        case 2 * 8 + 3: return bcsr_spmv_fixed<2, 3>(A, x.data(), y.data());
+        case 2 * 8 + 4: return bcsr_spmv_fixed<2, 4>(A, x.data(), y.data());
+        case 3 * 8 + 1: return bcsr_spmv_fixed<3, 1>(A, x.data(), y.data());
+        case 3 * 8 + 2: return bcsr_spmv_fixed<3, 2>(A, x.data(), y.data());
+        case 3 * 8 + 3: return bcsr_spmv_fixed<3, 3>(A, x.data(), y.data());
+        case 3 * 8 + 4: return bcsr_spmv_fixed<3, 4>(A, x.data(), y.data());
+        case 4 * 8 + 1: return bcsr_spmv_fixed<4, 1>(A, x.data(), y.data());
+        case 4 * 8 + 2: return bcsr_spmv_fixed<4, 2>(A, x.data(), y.data());
+        case 4 * 8 + 3: return bcsr_spmv_fixed<4, 3>(A, x.data(), y.data());
+        case 4 * 8 + 4: return bcsr_spmv_fixed<4, 4>(A, x.data(), y.data());
+    }
+    throw std::runtime_error("bcsr_spmv: no kernel for " + std::to_string(A.r) + "x" + std::to_string(A.c) + " blocks");
+}
+
+// 11. Out-of-core streaming SpMV over a .csrbin file: only x, y and two row
+// blocks are in memory. Blocks are cut so each buffer holds at most
+// budget_bytes / 2 (a single longer row still gets a block of its own); block
+// b+1 is read with large sequential preads on a helper thread while block b is
+// multiplied. With drop_cache the pages read are evicted again, so repeated
+// runs measure the disk rather than the page cache.
+struct StreamingStats {
+    int blocks = 0;
+    double bytes = 0;             // matrix bytes read
+    double plan_seconds = 0;      // scan of row_ptr to cut the blocks
+    double seconds = 0;           // streaming loop, wall clock
+    double io_seconds = 0;        // sum of block reads
+    double compute_seconds = 0;   // sum of block multiplies
+
+    double disk_gbps() const { return bytes / io_seconds / 1e9; }
+    double compute_gbps() const { return bytes / compute_seconds / 1e9; }
+    // Share of the shorter phase hidden under the longer one (1 = fully overlapped)
+    double overlap_efficiency() const {
+        double shorter = std::min(io_seconds, compute_seconds);
+        return shorter > 0 ? std::max(0.0, io_seconds + compute_seconds - seconds) / shorter : 0.0;
+    }
+};
+
+static void pread_full(int fd, void* buffer, size_t bytes, uint64_t offset, const std::string& filename) {
+    char* out = static_cast<char*>(buffer);
+    while (bytes > 0) {
+        ssize_t got = pread(fd, out, bytes, (off_t)offset);
+        if (got <= 0) throw std::runtime_error("Could not read " + filename);
+        out += got;
+        bytes -= got;
+        offset += got;
+    }
+}
+
+StreamingStats csr_spmv_streaming(const std::string& filename, const std::vector<double>& x, std::vector<double>& y,
+                                  size_t budget_bytes, bool drop_cache = true) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Could not open file " + filename);
+    struct FdGuard { int fd; ~FdGuard() { close(fd); } } guard{fd};
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(CSRFileHeader))
+        throw std::runtime_error(filename + " is too small to be a CSR file");
+    CSRFileHeader h;
+    pread_full(fd, &h, sizeof(h), 0, filename);
+    std::string error = csr_header_error(h, st.st_size);
+    if (!error.empty()) throw std::runtime_error(filename + ": " + error);
+    // A stale file for another matrix would index past the ends of x and y
+    if ((uint64_t)x.size() < (uint64_t)h.cols || (uint64_t)y.size() < (uint64_t)h.rows)
+        throw std::runtime_error(filename + ": x or y is smaller than the " + std::to_string(h.rows) + " x " +
+                                 std::to_string(h.cols) + " matrix");
+    if (drop_cache) posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    const int rows = (int)h.rows;
+    const size_t half = std::max<size_t>(budget_bytes / 2, 64);
+    auto block_bytes = [](long long nrows, long long nnz) { return (nrows + 1) * sizeof(int) + nnz * (sizeof(int) + sizeof(double)); };
+    StreamingStats stats;
+
+    // Plan: scan row_ptr in budget-sized pieces and cut a block before it outgrows half the budget
+    auto plan_start = std::chrono::high_resolution_clock::now();
+    std::vector<int> starts(1, 0);
+    {
+        std::vector<int> piece(std::clamp<size_t>(half / sizeof(int), 2, 1 << 20));
+        int block_row = 0, block_base = 0, prev = 0;
+        for (long long first = 0; first <= rows; first += piece.size()) {
+            size_t count = std::min<size_t>(piece.size(), rows + 1 - first);
+            pread_full(fd, piece.data(), count * sizeof(int), h.row_ptr_offset + first * sizeof(int), filename);
+            for (size_t k = 0; k < count; k++) {
+                long long r = first + k;
+                if (r > block_row + 1 && block_bytes(r - block_row, piece[k] - block_base) > half) {
+                    block_row = (int)r - 1;
+                    block_base = prev;
+                    starts.push_back(block_row);
+                }
+                prev = piece[k];
+            }
+        }
+        if (starts.back() != rows) starts.push_back(rows);
+    }
+    stats.plan_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - plan_start).count();
+    stats.blocks = (int)starts.size() - 1;
+
+    // Two buffers, sized once for the largest block
+    struct Block {
+        std::vector<int> row_ptr;
+        std::vector<int> col_indices;
+        std::vector<double> values;
+        int first_row = 0, rows = 0, nnz = 0;
+        double seconds = 0;
+    } buffers[2];
+
+    auto load = [&](int b, Block& block) {
+        auto start = std::chrono::high_resolution_clock::now();
+        block.first_row = starts[b];
+        block.rows = starts[b + 1] - starts[b];
+        block.row_ptr.resize(block.rows + 1);
+        uint64_t row_ptr_at = h.row_ptr_offset + (uint64_t)block.first_row * sizeof(int);
+        pread_full(fd, block.row_ptr.data(), (block.rows + 1) * sizeof(int), row_ptr_at, filename);
+        const int base = block.row_ptr[0];
+        block.nnz = block.row_ptr[block.rows] - base;
+        for (int& p : block.row_ptr) p -= base;
+        if (block.col_indices.size() < (size_t)block.nnz) {
+            block.col_indices.resize(block.nnz);
+            block.values.resize(block.nnz);
+        }
+        uint64_t cols_at = h.col_indices_offset + (uint64_t)base * sizeof(int);
+        uint64_t values_at = h.values_offset + (uint64_t)base * sizeof(double);
+        pread_full(fd, block.col_indices.data(), block.nnz * sizeof(int), cols_at, filename);
+        pread_full(fd, block.values.data(), block.nnz * sizeof(double), values_at, filename);
+        if (drop_cache) {
+            posix_fadvise(fd, row_ptr_at, (block.rows + 1) * sizeof(int), POSIX_FADV_DONTNEED);
+            posix_fadvise(fd, cols_at, block.nnz * sizeof(int), POSIX_FADV_DONTNEED);
+            posix_fadvise(fd, values_at, block.nnz * sizeof(double), POSIX_FADV_DONTNEED);
+        }
+        block.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+
+    const auto kernel = csr_kernels_for<int, int>(spmv_kernels.isa).parallel;
+    auto loop_start = std::chrono::high_resolution_clock::now();
+    // A 0-row matrix has no blocks, and starts[1] does not exist
+    std::future<void> pending;
+    if (stats.blocks > 0) pending = std::async(std::launch::async, load, 0, std::ref(buffers[0]));
+    for (int b = 0; b < stats.blocks; b++) {
+        pending.get();
+        Block& block = buffers[b % 2];
+        stats.io_seconds += block.seconds;
+        stats.bytes += block_bytes(block.rows, block.nnz);
+        if (b + 1 < stats.blocks) pending = std::async(std::launch::async, load, b + 1, std::ref(buffers[(b + 1) % 2]));
+
+        auto start = std::chrono::high_resolution_clock::now();
+        CSRView view = { block.rows, (int)h.cols, block.nnz, block.values.data(), block.col_indices.data(), block.row_ptr.data() };
+        kernel(view, x.data(), y.data() + block.first_row, nullptr);
+        stats.compute_seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - loop_start).count();
+    return stats;
+}
+
+// 12. Iterative solvers: CG, Jacobi-preconditioned CG and power iteration.
+// A solve is one persistent parallel region in which every thread owns a fixed,
+// nnz-balanced row range of all vectors. SpMV is fused with the dot product that
+// follows it and the vector updates with the norms they feed, so an iteration
+// is a few sweeps separated by barriers. Partial sums go to per-thread cache
+// lines that every thread adds up itself (same order, so the same result on
+// all threads); two alternating slots let a thread write the next partial
+// while slower ones are still reading the last.
+struct SolverStats {
+    int iterations = 0;
+    double residual = 0;                // ||b - Ax|| / ||b|| (CG), relative eigenvalue change (power)
+    double eigenvalue = 0;              // power iteration only
+    double seconds = 0;                 // whole solve, setup included
+    double bytes_per_iteration = 0;     // matrix + vector traffic of one iteration, each array once per sweep
+    std::vector<std::string> phase_names;
+    std::vector<double> phase_seconds;  // summed over iterations, barrier waits included
+
+    double iteration_seconds() const {
+        double total = 0;
+        for (double t : phase_seconds) total += t;
+        return total;
+    }
+    double gbps() const { return iterations ? bytes_per_iteration * iterations / iteration_seconds() / 1e9 : 0.0; }
+};
+
+struct alignas(64) SolverPartial {
+    double sum[2];
+};
+
+// Row boundaries of parts ranges with about the same nnz + rows each
+std::vector<int> balanced_row_split(const CSRView& A, int parts) {
+    std::vector<int> bounds(parts + 1);
+    long long total = (long long)A.nnz + A.rows;
+    for (int t = 0; t < parts; t++) {
+        long long target = total * t / parts;
+        int lo = 0, hi = A.rows;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if ((long long)A.row_ptr[mid] + mid < target) lo = mid + 1;
+            else hi = mid;
+        }
+        bounds[t] = lo;
+    }
+    bounds[parts] = A.rows;
+    return bounds;
+}
+
+static double csr_bytes(const CSRView& A) {
+    return A.nnz * (sizeof(double) + sizeof(int)) + (A.rows + 1.0) * sizeof(int);
+}
+
+// Solves A x = b for symmetric positive definite A, starting from x = 0, until
+// ||r|| <= tol * ||b|| or max_iter iterations. Phases per iteration:
+//   0  q = A p with p.q                        (one sweep)
+//   1  x += alpha p, r -= alpha q, z = r / diag(A), r.z and r.r
+//   2  p = z + beta p
+// Phase 2 needs beta, so it cannot join phase 1, and the next SpMV reads p
+// across row ranges, so it cannot join phase 2 either.
+SolverStats cg_solve(const CSRView& A, const std::vector<double>& b, std::vector<double>& x,
+                     bool jacobi = false, double tol = 1e-8, int max_iter = 1000) {
+    if (A.rows != A.cols) throw std::invalid_argument("CG needs a square matrix");
+    const int n = A.rows;
+    auto start = std::chrono::high_resolution_clock::now();
+    SolverStats stats;
+    stats.phase_names = {"SpMV+dot", "update+norms", "direction"};
+    stats.phase_seconds.assign(3, 0.0);
+    stats.bytes_per_iteration = csr_bytes(A) + n * sizeof(double) * (jacobi ? 13.0 : 11.0);
+
+    std::vector<double> inv_diag;
+    if (jacobi) {
+        inv_diag.assign(n, 0.0);
+        for (int i = 0; i < n; i++) {
+            for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++)
+                if (A.col_indices[k] == i) inv_diag[i] = 1.0 / A.values[k];
+            if (inv_diag[i] == 0.0 || !std::isfinite(inv_diag[i]))
+                throw std::invalid_argument("Jacobi preconditioner needs a nonzero diagonal");
+        }
+    }
+    x.assign(n, 0.0);
+    std::vector<double> r(n), p(n), q(n), z(jacobi ? n : 0);
+    double* zp = jacobi ? z.data() : r.data();
+    std::vector<int> bounds;
+    std::vector<SolverPartial> partial;
+
+    #pragma omp parallel
+    {
+        const int t = omp_get_thread_num(), T = omp_get_num_threads();
+        #pragma omp single
+        {
+            bounds = balanced_row_split(A, T);
+            partial.resize(2 * T);
+        }
+        const int r0 = bounds[t], r1 = bounds[t+1];
+        int slot = 0;
+        auto reduce = [&](double a, double c, double& sum_a, double& sum_c) {
+            partial[slot * T + t].sum[0] = a;
+            partial[slot * T + t].sum[1] = c;
+            #pragma omp barrier
+            sum_a = sum_c = 0.0;
+            for (int u = 0; u < T; u++) {
+                sum_a += partial[slot * T + u].sum[0];
+                sum_c += partial[slot * T + u].sum[1];
+            }
+            slot ^= 1;
+        };
+
+        double bb_part = 0.0, rz_part = 0.0;
+        for (int i = r0; i < r1; i++) {
+            r[i] = b[i];
+            if (jacobi) z[i] = b[i] * inv_diag[i];
+            p[i] = zp[i];
+            bb_part += b[i] * b[i];
+            rz_part += b[i] * zp[i];
+        }
+        double bb, rz;
+        reduce(bb_part, rz_part, bb, rz);
+        const double b_norm = std::sqrt(bb);
+        double rr = bb;
+
+        int it = 0;
+        double mark = omp_get_wtime();
+        auto lap = [&](int phase) {
+            if (t != 0) return;
+            double now = omp_get_wtime();
+            stats.phase_seconds[phase] += now - mark;
+            mark = now;
+        };
+        while (it < max_iter && std::sqrt(rr) > tol * b_norm) {
+            double pq_part, qq_part, pq, unused;
+            spmv_kernels.rows_dots(A, p.data(), q.data(), r0, r1, 1.0, &pq_part, &qq_part);
+            reduce(pq_part, 0.0, pq, unused);
+            lap(0);
+
+            const double alpha = rz / pq;
+            double rz_new;
+            rz_part = 0.0;
+            double rr_part = 0.0;
+            for (int i = r0; i < r1; i++) {
+                x[i] += alpha * p[i];
+                double ri = r[i] - alpha * q[i];
+                r[i] = ri;
+                double zi = jacobi ? ri * inv_diag[i] : ri;
+                if (jacobi) z[i] = zi;
+                rz_part += ri * zi;
+                rr_part += ri * ri;
+            }
+            reduce(rz_part, rr_part, rz_new, rr);
+            lap(1);
+
+            const double beta = rz_new / rz;
+            rz = rz_new;
+            for (int i = r0; i < r1; i++) p[i] = zp[i] + beta * p[i];
+            #pragma omp barrier
+            lap(2);
+            it++;
+        }
+        if (t == 0) {
+            stats.iterations = it;
+            stats.residual = b_norm > 0 ? std::sqrt(rr) / b_norm : 0.0;
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    return stats;
+}
+
+// Reference CG built from the separate kernels (parallel SpMV, then one
+// OpenMP loop per dot product and vector update), for comparison with cg_solve
+SolverStats cg_solve_unfused(const CSRView& A, const std::vector<double>& b, std::vector<double>& x,
+                             bool jacobi = false, double tol = 1e-8, int max_iter = 1000) {
+    const int n = A.rows;
+    auto start = std::chrono::high_resolution_clock::now();
+    SolverStats stats;
+    stats.phase_names = {"iteration"};
+    stats.phase_seconds.assign(1, 0.0);
+    stats.bytes_per_iteration = csr_bytes(A) + n * sizeof(double) * 19.0;
+
+    std::vector<double> inv_diag(n, 1.0);
+    if (jacobi)
+        for (int i = 0; i < n; i++)
+            for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++)
+                if (A.col_indices[k] == i) inv_diag[i] = 1.0 / A.values[k];
+    auto dot = [n](const std::vector<double>& u, const std::vector<double>& v) {
         double sum = 0.0;
-        for (int k = A.row_ptr[i]; k < A.row_ptr[i+1]; k++) {
-            sum += A.values[k] * x[A.col_indices[k]];
+        #pragma omp parallel for reduction(+:sum)
+        for (int i = 0; i < n; i++) sum += u[i] * v[i];
+        return sum;
+    };
+    x.assign(n, 0.0);
+    std::vector<double> r(b), z(n), p(n), q(n);
+    #pragma omp parallel for
+    for (int i = 0; i < n; i++) z[i] = p[i] = r[i] * inv_diag[i];
+    double rz = dot(r, z);
+    const double b_norm = std::sqrt(dot(b, b));
+    double r_norm = b_norm;
+
+    auto loop_start = std::chrono::high_resolution_clock::now();
+    int it = 0;
+    while (it < max_iter && r_norm > tol * b_norm) {
+        csr_spmv_parallel(A, p, q);
+        const double alpha = rz / dot(p, q);
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++) x[i] += alpha * p[i];
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++) r[i] -= alpha * q[i];
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++) z[i] = r[i] * inv_diag[i];
+        double rz_new = dot(r, z);
+        r_norm = std::sqrt(dot(r, r));
+        const double beta = rz_new / rz;
+        rz = rz_new;
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++) p[i] = z[i] + beta * p[i];
+        it++;
+    }
+    stats.phase_seconds[0] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - loop_start).count();
+    stats.iterations = it;
+    stats.residual = b_norm > 0 ? r_norm / b_norm : 0.0;
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    return stats;
+}
+
+// Dominant eigenvalue (largest magnitude, assumed real) of a square A, with its
+// unit eigenvector left in v (the start vector, seeded random if empty). Stops once
+// the Rayleigh quotient changes by at most tol relative. The normalization is
+// folded into the next SpMV (y = A x / ||x||), so an iteration is one sweep:
+//   0  y = A x / ||x|| with x.y and y.y
+SolverStats power_iteration(const CSRView& A, std::vector<double>& v, double tol = 1e-8, int max_iter = 1000) {
+    if (A.rows != A.cols) throw std::invalid_argument("Power iteration needs a square matrix");
+    const int n = A.rows;
+    auto start = std::chrono::high_resolution_clock::now();
+    SolverStats stats;
+    stats.phase_names = {"SpMV+dots"};
+    stats.phase_seconds.assign(1, 0.0);
+    stats.bytes_per_iteration = csr_bytes(A) + n * sizeof(double) * 2.0;
+
+    if (v.empty()) {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        v.resize(n);
+        for (double& vi : v) vi = unit(gen);
+    }
+    if ((int)v.size() != n) throw std::invalid_argument("Start vector size does not match the matrix");
+    std::vector<double> w(n);
+    std::vector<int> bounds;
+    std::vector<SolverPartial> partial;
+
+    #pragma omp parallel
+    {
+        const int t = omp_get_thread_num(), T = omp_get_num_threads();
+        #pragma omp single
+        {
+            bounds = balanced_row_split(A, T);
+            partial.resize(2 * T);
+        }
+        const int r0 = bounds[t], r1 = bounds[t+1];
+        int slot = 0;
+        auto reduce = [&](double a, double c, double& sum_a, double& sum_c) {
+            partial[slot * T + t].sum[0] = a;
+            partial[slot * T + t].sum[1] = c;
+            #pragma omp barrier
+            sum_a = sum_c = 0.0;
+            for (int u = 0; u < T; u++) {
+                sum_a += partial[slot * T + u].sum[0];
+                sum_c += partial[slot * T + u].sum[1];
+            }
+            slot ^= 1;
+        };
+
+        double xx_part = 0.0, xx, unused;
+        for (int i = r0; i < r1; i++) xx_part += v[i] * v[i];
+        reduce(xx_part, 0.0, xx, unused);
+
+        double* cur = v.data();
+        double* next = w.data();
+        double lambda = 0.0, change = std::numeric_limits<double>::infinity();
+        int it = 0;
+        double mark = omp_get_wtime();
+        while (it < max_iter && change > tol && xx > 0) {
+            // next = s A cur with s = 1 / ||cur||, so cur.A cur / cur.cur = xy / (s xx)
+            const double s = 1.0 / std::sqrt(xx);
+            double xy_part, yy_part, xy, yy;
+            spmv_kernels.rows_dots(A, cur, next, r0, r1, s, &xy_part, &yy_part);
+            reduce(xy_part, yy_part, xy, yy);
+            if (t == 0) {
+                double now = omp_get_wtime();
+                stats.phase_seconds[0] += now - mark;
+                mark = now;
+            }
+            double estimate = xy / (s * xx);
+            change = std::fabs(estimate - lambda) / std::max(std::fabs(estimate), 1e-300);
+            lambda = estimate;
+            xx = yy;
+            std::swap(cur, next);
+            it++;
+        }
+
+        const double s = xx > 0 ? 1.0 / std::sqrt(xx) : 0.0;
+        for (int i = r0; i < r1; i++) v[i] = cur[i] * s;
+        if (t == 0) {
+            stats.iterations = it;
+            stats.residual = change;
+            stats.eigenvalue = lambda;
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    return stats;
+}
+
+// 13. NUMA placement: a copy of A whose pages are first-touched by the thread
+// that owns rows bounds[t]..bounds[t+1] in the kernel (P.row of a
+// merge_path_partition, or balanced_row_split, with the same thread count).
+// Under NumaPolicy::Serial the calling thread copies everything instead.
+CSRMatrix csr_first_touch(const CSRView& A, const std::vector<int>& bounds) {
+    CSRMatrix B;
+    B.rows = A.rows; B.cols = A.cols; B.nnz = A.nnz;
+    B.values.resize(A.nnz);
+    B.col_indices.resize(A.nnz);
+    B.row_ptr.resize(A.rows + 1);
+    const int parts = (int)bounds.size() - 1;
+    auto copy_rows = [&](int t) {
+        const int r0 = bounds[t], r1 = bounds[t+1];
+        const int p0 = A.row_ptr[r0], p1 = A.row_ptr[r1];
+        if (t == 0) B.row_ptr[0] = A.row_ptr[0];
+        std::copy(A.row_ptr + r0 + 1, A.row_ptr + r1 + 1, B.row_ptr.data() + r0 + 1);
+        std::copy(A.col_indices + p0, A.col_indices + p1, B.col_indices.data() + p0);
+        std::copy(A.values + p0, A.values + p1, B.values.data() + p0);
+    };
+    if (numa_policy() == NumaPolicy::Serial) {
+        for (int t = 0; t < parts; t++) copy_rows(t);
+    } else {
+        // The team may be smaller than requested (OMP_THREAD_LIMIT, nesting):
+        // thread t then also takes parts t + T, t + 2T, ...
+        #pragma omp parallel num_threads(parts)
+        for (int t = omp_get_thread_num(); t < parts; t += omp_get_num_threads()) copy_rows(t);
+    }
+    return B;
+}
+
+// Vector of n doubles set to value, first-touched by the owners of bounds
+// (entries past the last bound, e.g. x of a wide matrix, go to the last part)
+KernelVector<double> vector_first_touch(int n, double value, const std::vector<int>& bounds) {
+    KernelVector<double> v(n);
+    const int parts = (int)bounds.size() - 1;
+    if (numa_policy() == NumaPolicy::Serial) {
+        std::fill(v.begin(), v.end(), value);
+    } else {
+        #pragma omp parallel num_threads(parts)
+        for (int t = omp_get_thread_num(); t < parts; t += omp_get_num_threads()) {
+            const int i0 = std::min(bounds[t], n), i1 = t == parts - 1 ? n : std::min(bounds[t+1], n);
+            std::fill(v.begin() + i0, v.begin() + i1, value);
         }
-        y[i] = sum;
     }
+    return v;
 }
 
 // Generator
 void generate_random(int rows, int cols, double sparsity, std::vector<double>& dense, CSRMatrix& sparse) {
-    dense.resize(rows * cols, 0.0);
+    dense.resize((size_t)rows * cols, 0.0);
     sparse.rows = rows; sparse.cols = cols;
     sparse.row_ptr.push_back(0);
     int nnz_count = 0;
@@ -150,7 +1973,7 @@ void generate_random(int rows, int cols, double sparsity, std::vector<double>& d
         for (int j = 0; j < cols; j++) {
             if ((rand() / (double)RAND_MAX) > sparsity) {
                 double val = 1.0;
-                dense[i * cols + j] = val;
+                dense[(size_t)i * cols + j] = val;
                 sparse.values.push_back(val);
                 sparse.col_indices.push_back(j);
                 nnz_count++;
@@ -161,11 +1984,154 @@ void generate_random(int rows, int cols, double sparsity, std::vector<double>& d
     sparse.nnz = nnz_count;
 }
 
+// 5-point Laplacian on a grid x grid mesh (symmetric, full storage)
+void generate_laplacian_2d(int grid, CSRMatrix& sparse) {
+    int n = grid * grid;
+    sparse.rows = n; sparse.cols = n;
+    sparse.row_ptr.assign(1, 0);
+    sparse.col_indices.clear();
+    sparse.values.clear();
+    for (int i = 0; i < n; i++) {
+        int gx = i % grid, gy = i / grid;
+        auto add = [&](int j, double v) { sparse.col_indices.push_back(j); sparse.values.push_back(v); };
+        if (gy > 0) add(i - grid, -1.0);
+        if (gx > 0) add(i - 1, -1.0);
+        add(i, 4.0);
+        if (gx + 1 < grid) add(i + 1, -1.0);
+        if (gy + 1 < grid) add(i + grid, -1.0);
+        sparse.row_ptr.push_back((int)sparse.col_indices.size());
+    }
+    sparse.nnz = sparse.row_ptr[n];
+}
+
+// Laplacian scaled symmetrically as D A D with d_i spread over two orders of
+// magnitude: still SPD, but badly scaled rows that Jacobi preconditioning undoes
+void generate_scaled_laplacian(int grid, CSRMatrix& sparse) {
+    generate_laplacian_2d(grid, sparse);
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> exponent(0.0, 2.0);
+    std::vector<double> d(sparse.rows);
+    for (double& di : d) di = std::pow(10.0, exponent(gen));
+    for (int i = 0; i < sparse.rows; i++)
+        for (int k = sparse.row_ptr[i]; k < sparse.row_ptr[i+1]; k++) sparse.values[k] *= d[i] * d[sparse.col_indices[k]];
+}
+
+// Laplacian with dof unknowns per grid node: every 5-point coupling becomes a
+// dense dof x dof block (the structure of vector-valued FEM problems)
+void generate_block_laplacian(int grid, int dof, CSRMatrix& sparse) {
+    CSRMatrix scalar;
+    generate_laplacian_2d(grid, scalar);
+    int n = scalar.rows * dof;
+    sparse.rows = n; sparse.cols = n;
+    sparse.row_ptr.assign(1, 0);
+    sparse.col_indices.clear();
+    sparse.values.clear();
+    for (int node = 0; node < scalar.rows; node++)
+        for (int d = 0; d < dof; d++) {
+            for (int k = scalar.row_ptr[node]; k < scalar.row_ptr[node + 1]; k++)
+                for (int e = 0; e < dof; e++) {
+                    sparse.col_indices.push_back(scalar.col_indices[k] * dof + e);
+                    sparse.values.push_back(scalar.values[k] * (d == e ? 1.0 : 0.25));
+                }
+            sparse.row_ptr.push_back((int)sparse.col_indices.size());
+        }
+    sparse.nnz = sparse.row_ptr[n];
+}
+
+// Square matrix with Pareto-distributed row lengths (mean avg_nnz): mostly
+// short rows plus a few very heavy ones, the worst case for row scheduling
+void generate_power_law(int n, double avg_nnz, CSRMatrix& sparse) {
+    const double alpha = 1.5;
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> col(0, n - 1);
+    sparse.rows = n; sparse.cols = n;
+    sparse.row_ptr.assign(1, 0);
+    sparse.col_indices.clear();
+    sparse.values.clear();
+    std::vector<int> row;
+    for (int i = 0; i < n; i++) {
+        double len = avg_nnz * (alpha - 1) / alpha / std::pow(1.0 - unit(gen), 1.0 / alpha);
+        int count = (int)std::min<double>(len, n / 4);
+        row.resize(count);
+        for (int& c : row) c = col(gen);
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        for (int c : row) {
+            sparse.col_indices.push_back(c);
+            sparse.values.push_back(unit(gen));
+        }
+        sparse.row_ptr.push_back((int)sparse.col_indices.size());
+    }
+    sparse.nnz = sparse.row_ptr[n];
+}
+
 // ==========================================
 // 4. MAIN EXPERIMENTS
 // ==========================================
-int main() {
+
+// Reads a "<key>: <n> kB" field of /proc/self/status (0 if unavailable)
+long read_status_kb(const std::string& key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.rfind(key + ":", 0) == 0) return std::atol(line.c_str() + key.size() + 1);
+    return 0;
+}
+
+// Peak RSS in MB reached while fn runs, above the RSS before it started
+// (writing 5 to clear_refs resets VmHWM to the current RSS)
+template <class Fn>
+double peak_rss_mb(Fn&& fn) {
+    std::ofstream("/proc/self/clear_refs") << "5";
+    long base_kb = read_status_kb("VmRSS");
+    fn();
+    return (read_status_kb("VmHWM") - base_kb) / 1024.0;
+}
+
+// Fastest of reps runs of fn (after one warmup run), in seconds
+template <class Fn>
+double best_of(int reps, Fn&& fn) {
+    BenchConfig config;
+    config.min_reps = config.max_reps = reps;
+    return bench_measure(config, fn).min;
+}
+
+// Compulsory traffic of one SpMV: the matrix, x and y once each
+double spmv_bytes(const CSRView& A) {
+    return A.nnz * (sizeof(double) + sizeof(int)) + (A.rows + 1.0) * sizeof(int) + (A.rows + A.cols) * sizeof(double);
+}
+
+double dense_spmv_bytes(int rows, int cols) {
+    return ((double)rows * cols + rows + cols) * sizeof(double);
+}
+
+int main(int argc, char* argv[]) {
     srand(42);
+
+    // Optional flags: --isa=<scalar|sse2|avx2|avx512|auto> forces a kernel version,
+    // --counters adds hardware counters (perf_event_open) to the harness results,
+    // --pin=<none|close|spread> binds one thread per CPU for experiments A-N
+    // (Experiment O always pins close), --pages=<small|thp|hugetlb> sets the page
+    // size behind large matrices and vectors (default thp; Experiment P sweeps it)
+    std::string isa;
+    PinPolicy pin = PinPolicy::None;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--isa=", 0) == 0) isa = arg.substr(6);
+        else if (arg == "--counters" && perf_enable(true) == 0)
+            std::cerr << "Warning: hardware counters not available, timing only" << std::endl;
+        else if (arg == "--pin=close") pin = PinPolicy::Close;
+        else if (arg == "--pin=spread") pin = PinPolicy::Spread;
+        else if (arg == "--pages=small") page_strategy() = PageStrategy::Small;
+        else if (arg == "--pages=thp") page_strategy() = PageStrategy::Transparent;
+        else if (arg == "--pages=hugetlb") page_strategy() = PageStrategy::HugeTLB;
+    }
+    if (pin != PinPolicy::None) pin_threads(pin);
+    spmv_kernels = spmv_kernels_for(select_isa(isa));
+    std::cout << "Sparse kernels: " << isa_name(spmv_kernels.isa) << std::endl;
+    const Roofline& roof = machine_roofline(spmv_kernels.isa);
+    std::cout << "Roofline: " << roof.peak_gflops << " GFLOPS peak, " << roof.peak_gbps << " GB/s triad" << std::endl;
     
     // ---------------------------------------------------------
     // EXPERIMENT A: Sparsity Analysis (Fixed Size: 3000 x 3000)
@@ -173,7 +2139,10 @@ int main() {
     std::cout << "Running Experiment A: Sparsity Levels..." << std::endl;
     std::ofstream csv_sparsity("results/results_sparsity.csv");
     csv_sparsity << "Sparsity,NaiveDense,OptDense,SparseCSR\n";
-    
+
+    // Every kernel runs through the harness (warmup, then repetitions); the
+    // CSV keeps its columns with the median time, the JSON has all statistics
+    BenchSuite bench_sparsity;
     int N_fixed = 3000;
     std::vector<double> sparsities = {0.0, 0.25, 0.50, 0.75, 0.90, 0.95, 0.99};
     
@@ -182,25 +2151,23 @@ int main() {
         CSRMatrix sparse_mat;
         generate_random(N_fixed, N_fixed, s, dense_mat, sparse_mat);
 
-        // 1. Naive
-        auto start = std::chrono::high_resolution_clock::now();
-        dense_spmv_naive(dense_mat, x, y, N_fixed, N_fixed);
-        double t_naive = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
-
-        // 2. Opt Dense
-        start = std::chrono::high_resolution_clock::now();
-        dense_spmv_optimized(dense_mat, x, y, N_fixed, N_fixed);
-        double t_opt = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
-
-        // 3. Sparse
-        start = std::chrono::high_resolution_clock::now();
-        csr_spmv(sparse_mat, x, y);
-        double t_sparse = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        BenchSuite::Params params = {{"Sparsity", bench_str(s)}};
+        double dense_flops = 2.0 * N_fixed * N_fixed, dense_bytes = dense_spmv_bytes(N_fixed, N_fixed);
+        bench_sparsity.add("NaiveDense", params, dense_flops, dense_bytes,
+                           [&] { dense_spmv_naive(dense_mat, x, y, N_fixed, N_fixed); });
+        bench_sparsity.add("OptDense", params, dense_flops, dense_bytes,
+                           [&] { dense_spmv_optimized(dense_mat, x, y, N_fixed, N_fixed); });
+        bench_sparsity.add("SparseCSR", params, 2.0 * sparse_mat.nnz, spmv_bytes(sparse_mat.view()),
+                           [&] { csr_spmv(sparse_mat, x, y); });
+        const auto& r = bench_sparsity.run();
+        size_t last = r.size() - 3;
 
-        csv_sparsity << s << "," << t_naive << "," << t_opt << "," << t_sparse << "\n";
+        csv_sparsity << s << "," << r[last].stats.median << "," << r[last + 1].stats.median << ","
+                     << r[last + 2].stats.median << "\n";
         std::cout << "  Sparsity " << s * 100 << "% done." << std::endl;
     }
     csv_sparsity.close();
+    bench_sparsity.write_json("results/results_sparsity.json");
 
     // ---------------------------------------------------------
     // EXPERIMENT B: Matrix Size Scaling (Fixed Sparsity: 90%)
@@ -209,6 +2176,7 @@ int main() {
     std::ofstream csv_size("results/results_size.csv");
     csv_size << "Size,NaiveDense,OptDense,SparseCSR\n";
 
+    BenchSuite bench_size;
     double s_fixed = 0.90;
     
     // Testing sizes from 1000 to 10000
@@ -217,48 +2185,626 @@ int main() {
         CSRMatrix sparse_mat;
         generate_random(N, N, s_fixed, dense_mat, sparse_mat);
 
-        // 1. Naive
-        auto start = std::chrono::high_resolution_clock::now();
-        dense_spmv_naive(dense_mat, x, y, N, N);
-        double t_naive = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
-
-        // 2. Opt Dense
-        start = std::chrono::high_resolution_clock::now();
-        dense_spmv_optimized(dense_mat, x, y, N, N);
-        double t_opt = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        BenchSuite::Params params = {{"Size", bench_str(N)}};
+        double dense_flops = 2.0 * N * N, dense_bytes = dense_spmv_bytes(N, N);
+        bench_size.add("NaiveDense", params, dense_flops, dense_bytes, [&] { dense_spmv_naive(dense_mat, x, y, N, N); });
+        bench_size.add("OptDense", params, dense_flops, dense_bytes, [&] { dense_spmv_optimized(dense_mat, x, y, N, N); });
+        bench_size.add("SparseCSR", params, 2.0 * sparse_mat.nnz, spmv_bytes(sparse_mat.view()),
+                       [&] { csr_spmv(sparse_mat, x, y); });
+        const auto& r = bench_size.run();
+        size_t last = r.size() - 3;
 
-        // 3. Sparse
-        start = std::chrono::high_resolution_clock::now();
-        csr_spmv(sparse_mat, x, y);
-        double t_sparse = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
-
-        csv_size << N << "," << t_naive << "," << t_opt << "," << t_sparse << "\n";
+        csv_size << N << "," << r[last].stats.median << "," << r[last + 1].stats.median << ","
+                 << r[last + 2].stats.median << "\n";
         std::cout << "  Size " << N << "x" << N << " done." << std::endl;
     }
     csv_size.close();
+    bench_size.write_json("results/results_size.json");
 
     // ---------------------------------------------------------
     // EXPERIMENT C: Huge Matrix File (Sparse Only)
     // ---------------------------------------------------------
     std::cout << "Running Experiment C: Huge Matrix (mc2depi.mtx)..." << std::endl;
     try {
-        CSRMatrix bigMat = readMTX("data/mc2depi.mtx");
+        // First run converts the .mtx into data/mc2depi.csrbin; later runs only mmap it
+        auto load_start = std::chrono::high_resolution_clock::now();
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        double t_load = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - load_start).count();
+        const CSRView& bigMat = mapped.view();
+        std::cout << "  Load time:       " << t_load << " s (" << bigMat.rows << " rows, " << bigMat.nnz << " nnz)" << std::endl;
         std::vector<double> x_big(bigMat.cols, 1.0), y_big(bigMat.rows, 0.0);
         
+        BenchSuite bench_huge;
+        BenchSuite::Params params = {{"Matrix", "mc2depi"}};
+        bench_huge.add("SparseCSR", params, 2.0 * bigMat.nnz, spmv_bytes(bigMat), [&] { csr_spmv(bigMat, x_big, y_big); });
+        bench_huge.add("ParallelCSR", params, 2.0 * bigMat.nnz, spmv_bytes(bigMat),
+                       [&] { csr_spmv_parallel(bigMat, x_big, y_big); });
+        std::cout << "  Huge Matrix Results:" << std::endl;
+        bench_huge.run();
+        bench_huge.write_csv("results/results_huge.csv");
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping huge matrix (" << e.what() << ")." << std::endl;
+    }
+
+    // ---------------------------------------------------------
+    // EXPERIMENT D: Matrix Market parser throughput
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment D: Parser Comparison..." << std::endl;
+    {
+        // Many short rows: a per-thread row histogram would dwarf the entries here,
+        // so peak RSS shows whether the parser's extra memory grows with threads
+        const int wide_rows = 1000000;
+        {
+            std::error_code ec;
+            std::filesystem::create_directories("data", ec);
+            std::ofstream out("data/parser_rows.mtx");
+            out << "%%MatrixMarket matrix coordinate real general\n"
+                << wide_rows << " " << wide_rows << " " << 2 * wide_rows << "\n";
+            std::mt19937 gen(7);
+            std::uniform_int_distribution<int> col(1, wide_rows);
+            for (int i = 1; i <= wide_rows; i++) out << i << " " << i << " 4\n" << i << " " << col(gen) << " -1\n";
+            out.close();
+            if (!out) {
+                std::cerr << "  ERROR: could not write data/parser_rows.mtx, rows_1M is not measured" << std::endl;
+                std::remove("data/parser_rows.mtx");
+            }
+        }
+
+        std::ofstream csv_parser("results/results_parser.csv");
+        csv_parser << "Matrix,Parser,Threads,Seconds,GBps,PeakRSSMB\n";
+        const int default_threads = omp_get_max_threads();
+        auto run_parser = [&](const std::string& matrix, const std::string& path, double gb, const std::string& name,
+                              int threads, CSRMatrix (*parse)(const std::string&)) {
+            double t = 0;
+            omp_set_num_threads(threads);
+            double rss = peak_rss_mb([&] {
+                auto start = std::chrono::high_resolution_clock::now();
+                CSRMatrix mat = parse(path);
+                t = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            });
+            omp_set_num_threads(default_threads);
+            csv_parser << matrix << "," << name << "," << threads << "," << t << "," << gb / t << "," << rss << "\n";
+            std::cout << "  " << std::left << std::setw(12) << matrix << std::setw(15) << name << std::setw(4) << threads
+                      << t << " s, " << gb / t << " GB/s, peak RSS +" << rss << " MB" << std::endl;
+        };
+        for (auto [matrix, path] : {std::pair<std::string, std::string>{"mc2depi", "data/mc2depi.mtx"},
+                                    {"rows_1M", "data/parser_rows.mtx"}}) {
+            std::ifstream mtx_probe(path, std::ios::binary | std::ios::ate);
+            if (!mtx_probe) {
+                std::cout << "  Skipping " << matrix << " (file not found)." << std::endl;
+                continue;
+            }
+            double gb = mtx_probe.tellg() / 1e9;
+            run_parser(matrix, path, gb, "Stream", 1, readMTX);
+            for (int threads : {default_threads, 64}) {
+                if (threads == 64 && default_threads == 64) break;
+                run_parser(matrix, path, gb, "Parallel mmap", threads,
+                           [](const std::string& f) { return readMTX_parallel(f); });
+            }
+        }
+        csv_parser.close();
+        std::remove("data/parser_rows.mtx");
+    }
+
+    // ---------------------------------------------------------
+    // EXPERIMENT E: Load balance, row-dynamic vs merge-path (1..all threads)
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment E: Load Balancing..." << std::endl;
+    std::ofstream csv_balance("results/results_balance.csv");
+    csv_balance << "Matrix,Kernel,Threads,Seconds,Imbalance\n";
+
+    const int max_threads = omp_get_max_threads();
+    const int reps = 20;
+    auto run_balance = [&](const std::string& name, const CSRView& A) {
+        std::vector<double> x(A.cols, 1.0), y(A.rows, 0.0), thread_time(max_threads);
+        // Best of reps; imbalance = slowest thread / mean thread busy time on that run
+        auto measure = [&](const std::string& kernel, int threads, auto&& run) {
+            double best = 1e30, imbalance = 1.0;
+            for (int r = 0; r < reps; r++) {
+                std::fill(thread_time.begin(), thread_time.end(), 0.0);
+                auto start = std::chrono::high_resolution_clock::now();
+                run();
+                double t = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+                if (t < best) {
+                    best = t;
+                    double sum = 0, worst = 0;
+                    for (int i = 0; i < threads; i++) { sum += thread_time[i]; worst = std::max(worst, thread_time[i]); }
+                    imbalance = sum > 0 ? worst * threads / sum : 1.0;
+                }
+            }
+            csv_balance << name << "," << kernel << "," << threads << "," << best << "," << imbalance << "\n";
+            std::cout << "  " << name << " " << std::left << std::setw(12) << kernel << " threads=" << threads
+                      << " " << best << " s, imbalance " << imbalance << std::endl;
+        };
+        for (int threads = 1; threads <= max_threads; threads++) {
+            omp_set_num_threads(threads);
+            MergePartition P = merge_path_partition(A, threads);
+            measure("RowDynamic", threads, [&] { csr_spmv_parallel(A, x, y, thread_time.data()); });
+            measure("MergePath", threads, [&] { csr_spmv_merge(A, P, x, y, thread_time.data()); });
+        }
+        omp_set_num_threads(max_threads);
+    };
+
+    CSRMatrix power_law;
+    generate_power_law(200000, 16, power_law);
+    run_balance("PowerLaw", power_law.view());
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_balance("mc2depi", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_balance.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT F: SELL-C-sigma vs CSR (padding overhead per sigma)
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment F: SELL-C-sigma..." << std::endl;
+    std::ofstream csv_sell("results/results_sell.csv");
+    csv_sell << "Matrix,Sigma,PaddingPct,ConvertSeconds,CSRSeconds,CSRMergeSeconds,SELLSeconds\n";
+
+    auto run_sell = [&](const std::string& name, const CSRView& A) {
+        std::vector<double> x(A.cols, 1.0), y(A.rows, 0.0);
+        MergePartition P = merge_path_partition(A, omp_get_max_threads());
+        double t_csr = best_of(reps, [&] { csr_spmv_parallel(A, x, y); });
+        double t_merge = best_of(reps, [&] { csr_spmv_merge(A, P, x, y); });
+        for (int sigma : {1, SELL_C * 4, 256, 4096, A.rows}) {
+            auto start = std::chrono::high_resolution_clock::now();
+            SellMatrix S = csr_to_sell(A, sigma);
+            double t_convert = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            double t_sell = best_of(reps, [&] { sell_spmv_parallel(S, x, y); });
+            csv_sell << name << "," << sigma << "," << 100 * S.padding_overhead() << "," << t_convert << ","
+                     << t_csr << "," << t_merge << "," << t_sell << "\n";
+            std::cout << "  " << name << " sigma=" << std::left << std::setw(8) << sigma << " padding "
+                      << 100 * S.padding_overhead() << "%, SELL " << t_sell << " s vs CSR " << t_csr
+                      << " s / merge-path " << t_merge << " s" << std::endl;
+        }
+    };
+
+    run_sell("PowerLaw", power_law.view());
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_sell("mc2depi", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_sell.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT G: Symmetric half storage vs full CSR
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment G: Symmetric Storage..." << std::endl;
+    std::ofstream csv_sym("results/results_symmetric.csv");
+    csv_sym << "Matrix,Storage,MB,SerialSeconds,ParallelSeconds\n";
+
+    auto csr_mb = [](const CSRView& A) {
+        return (A.nnz * (sizeof(double) + sizeof(int)) + (A.rows + 1.0) * sizeof(int)) / 1e6;
+    };
+    auto run_sym = [&](const std::string& name, const CSRView& full, const CSRView& lower) {
+        std::vector<double> x(full.cols, 1.0), y(full.rows, 0.0);
+        MergePartition P = merge_path_partition(full, omp_get_max_threads());
+        SymPartition S = sym_partition(lower, omp_get_max_threads());
+        double t_full = best_of(reps, [&] { csr_spmv(full, x, y); });
+        double t_full_par = best_of(reps, [&] { csr_spmv_merge(full, P, x, y); });
+        double t_sym = best_of(reps, [&] { sym_spmv(lower, x, y); });
+        double t_sym_par = best_of(reps, [&] { sym_spmv_parallel(lower, S, x, y); });
+        csv_sym << name << ",Full," << csr_mb(full) << "," << t_full << "," << t_full_par << "\n";
+        csv_sym << name << ",Lower," << csr_mb(lower) << "," << t_sym << "," << t_sym_par << "\n";
+        std::cout << "  " << name << " full:  " << csr_mb(full) << " MB, " << t_full << " s serial, "
+                  << t_full_par << " s parallel" << std::endl;
+        std::cout << "  " << name << " lower: " << csr_mb(lower) << " MB, " << t_sym << " s serial, "
+                  << t_sym_par << " s parallel" << std::endl;
+    };
+
+    CSRMatrix laplacian;
+    generate_laplacian_2d(1000, laplacian);
+    CSRMatrix laplacian_lower = csr_lower_triangle(laplacian.view());
+    run_sym("Laplacian2D", laplacian.view(), laplacian_lower.view());
+    csv_sym.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT H: Reordering (RCM / partition) for x locality
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment H: Reordering..." << std::endl;
+    std::ofstream csv_reorder("results/results_reorder.csv");
+    csv_reorder << "Matrix,Ordering,Bandwidth,Profile,ReorderSeconds,SpMVSeconds,Speedup,BreakEvenIterations\n";
+
+    auto run_reorder = [&](const std::string& name, const CSRView& A) {
+        std::vector<double> x(A.cols, 1.0), y(A.rows, 0.0);
+        auto spmv_time = [&](const CSRView& M) {
+            MergePartition P = merge_path_partition(M, omp_get_max_threads());
+            return best_of(reps, [&] { csr_spmv_merge(M, P, x, y); });
+        };
+        auto report = [&](const std::string& ordering, const CSRView& M, double t_reorder, double t_base, double t) {
+            BandwidthStats stats = bandwidth_stats(M);
+            double gain = t_base - t;
+            csv_reorder << name << "," << ordering << "," << stats.bandwidth << "," << stats.profile << "," << t_reorder
+                        << "," << t << "," << t_base / t << "," << (gain > 0 ? t_reorder / gain : INFINITY) << "\n";
+            std::cout << "  " << name << " " << std::left << std::setw(10) << ordering << " bandwidth "
+                      << stats.bandwidth << ", profile " << stats.profile << ", reorder " << t_reorder
+                      << " s, SpMV " << t << " s (x" << t_base / t << ")" << std::endl;
+        };
+
+        double t_base = spmv_time(A);
+        report("Natural", A, 0.0, t_base, t_base);
+        auto run_ordering = [&](const std::string& ordering, auto&& make_order) {
+            auto start = std::chrono::high_resolution_clock::now();
+            CSRMatrix B = permute_csr(A, make_order());
+            double t_reorder = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            report(ordering, B.view(), t_reorder, t_base, spmv_time(B.view()));
+        };
+        run_ordering("RCM", [&] { return rcm_ordering(A); });
+        run_ordering("Partition", [&] { return partition_ordering(A, 4096); });
+    };
+
+    // The Laplacian under a random numbering: locality the original grid order had, lost
+    std::vector<int> shuffle(laplacian.rows);
+    for (int i = 0; i < laplacian.rows; i++) shuffle[i] = i;
+    std::shuffle(shuffle.begin(), shuffle.end(), std::mt19937(42));
+    CSRMatrix scrambled = permute_csr(laplacian.view(), shuffle);
+    run_reorder("Laplacian2D-shuffled", scrambled.view());
+    run_reorder("PowerLaw", power_law.view());
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_reorder("mc2depi", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_reorder.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT I: SpMM on k vectors vs k separate SpMVs
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment I: Multi-vector SpMM..." << std::endl;
+    std::ofstream csv_spmm("results/results_spmm.csv");
+    csv_spmm << "Matrix,K,SpMMSeconds,SpMMGFLOPS,SpMMBytesPerFlop,SeparateSeconds,SeparateGFLOPS,SeparateBytesPerFlop\n";
+
+    // Compulsory traffic: the matrix once per call, every x and y entry once
+    auto run_spmm = [&](const std::string& name, const CSRView& A) {
+        const double matrix_bytes = A.nnz * (sizeof(double) + sizeof(int)) + (A.rows + 1.0) * sizeof(int);
+        for (int k : {1, 2, 4, 8, 16, 32}) {
+            std::vector<double> X((size_t)A.cols * k, 1.0), Y((size_t)A.rows * k, 0.0);
+            std::vector<std::vector<double>> xs(k, std::vector<double>(A.cols, 1.0)), ys(k, std::vector<double>(A.rows, 0.0));
+            double t_spmm = best_of(reps, [&] { csr_spmm(A, X, Y, k); });
+            double t_separate = best_of(reps, [&] { for (int c = 0; c < k; c++) csr_spmv_parallel(A, xs[c], ys[c]); });
+
+            double flops = 2.0 * A.nnz * k;
+            double vector_bytes = (double)(A.cols + A.rows) * k * sizeof(double);
+            double spmm_bpf = (matrix_bytes + vector_bytes) / flops;
+            double separate_bpf = (k * matrix_bytes + vector_bytes) / flops;
+            csv_spmm << name << "," << k << "," << t_spmm << "," << flops / t_spmm / 1e9 << "," << spmm_bpf << ","
+                     << t_separate << "," << flops / t_separate / 1e9 << "," << separate_bpf << "\n";
+            std::cout << "  " << name << " k=" << std::left << std::setw(3) << k << " SpMM " << flops / t_spmm / 1e9
+                      << " GFLOPS (" << spmm_bpf << " B/flop) vs separate " << flops / t_separate / 1e9
+                      << " GFLOPS (" << separate_bpf << " B/flop)" << std::endl;
+        }
+    };
+
+    run_spmm("PowerLaw", power_law.view());
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_spmm("mc2depi", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_spmm.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT J: Sparse x Sparse (SpGEMM)
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment J: SpGEMM..." << std::endl;
+    std::ofstream csv_spgemm("results/results_spgemm.csv");
+    csv_spgemm << "Matrix,Operation,NnzA,NnzC,Flops,SymbolicSeconds,NumericSeconds,GFLOPS\n";
+
+    auto run_spgemm = [&](const std::string& name, const std::string& operation, const CSRView& A, const CSRView& B) {
         auto start = std::chrono::high_resolution_clock::now();
-        csr_spmv(bigMat, x_big, y_big);
-        double t_basic = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        CSRMatrix C;
+        C.rows = A.rows; C.cols = B.cols;
+        C.row_ptr = spgemm_symbolic(A, B);
+        double t_symbolic = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        C.nnz = C.row_ptr[A.rows];
+        C.col_indices.resize(C.nnz);
+        C.values.resize(C.nnz);
+        double t_numeric = best_of(3, [&] { spgemm_numeric(A, B, C); });
+        double flops = spgemm_flops(A, B);
+        double gflops = flops / (t_symbolic + t_numeric) / 1e9;
+        csv_spgemm << name << "," << operation << "," << A.nnz << "," << C.nnz << "," << flops << ","
+                   << t_symbolic << "," << t_numeric << "," << gflops << "\n";
+        std::cout << "  " << name << " " << operation << ": nnz(C) " << C.nnz << ", symbolic " << t_symbolic
+                  << " s, numeric " << t_numeric << " s, " << gflops << " GFLOPS" << std::endl;
+    };
+
+    CSRMatrix power_law_t = csr_transpose(power_law.view());
+    run_spgemm("Laplacian2D", "A*A", laplacian.view(), laplacian.view());
+    run_spgemm("PowerLaw", "A*A", power_law.view(), power_law.view());
+    run_spgemm("PowerLaw", "A*At", power_law.view(), power_law_t.view());
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_spgemm("mc2depi", "A*A", mapped.view(), mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_spgemm.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT K: Block CSR with auto-detected block size
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment K: Block CSR..." << std::endl;
+    std::ofstream csv_bcsr("results/results_bcsr.csv");
+    csv_bcsr << "Matrix,Block,EstimatedFill,FillRatio,CSRMB,BCSRMB,CSRSeconds,BCSRSeconds,Speedup\n";
 
-        start = std::chrono::high_resolution_clock::now();
-        csr_spmv_parallel(bigMat, x_big, y_big);
-        double t_parallel = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    auto run_bcsr = [&](const std::string& name, const CSRView& A) {
+        std::vector<double> x(A.cols, 1.0), y(A.rows, 0.0);
+        int r, c;
+        bcsr_choose_block(A, r, c);
+        double estimate = bcsr_fill_estimate(A, r, c, std::max(1, A.rows / r / 4096));
+        BCSRMatrix B = csr_to_bcsr(A, r, c);
+        MergePartition P = merge_path_partition(A, omp_get_max_threads());
+        double t_csr = best_of(reps, [&] { csr_spmv_merge(A, P, x, y); });
+        double t_bcsr = best_of(reps, [&] { bcsr_spmv(B, x, y); });
+        double csr_mb = (A.nnz * (sizeof(double) + sizeof(int)) + (A.rows + 1.0) * sizeof(int)) / 1e6;
+        double bcsr_mb = (B.values.size() * sizeof(double) + B.blocks() * sizeof(int) + (B.block_rows + 1.0) * sizeof(int)) / 1e6;
+        std::string block = std::to_string(r) + "x" + std::to_string(c);
+        csv_bcsr << name << "," << block << "," << estimate << "," << B.fill_ratio() << "," << csr_mb << "," << bcsr_mb
+                 << "," << t_csr << "," << t_bcsr << "," << t_csr / t_bcsr << "\n";
+        std::cout << "  " << name << " block " << block << " (fill " << B.fill_ratio() << ", estimated " << estimate
+                  << "): " << csr_mb << " -> " << bcsr_mb << " MB, CSR " << t_csr << " s, BCSR " << t_bcsr
+                  << " s (x" << t_csr / t_bcsr << ")" << std::endl;
+    };
 
-        std::cout << "  Huge Matrix Results:" << std::endl;
-        std::cout << "  Basic Sparse:    " << t_basic << " s" << std::endl;
-        std::cout << "  Parallel Sparse: " << t_parallel << " s" << std::endl;
-    } catch (...) {
-        std::cout << "  Skipping huge matrix (file not found)." << std::endl;
+    for (int dof : {1, 2, 3, 4}) {
+        CSRMatrix fem;
+        generate_block_laplacian(dof == 1 ? 1000 : 400, dof, fem);
+        run_bcsr("BlockLaplacian-dof" + std::to_string(dof), fem.view());
+    }
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_bcsr("mc2depi", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_bcsr.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT L: Offset / index width (32-bit path must not be slower)
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment L: Index Widths..." << std::endl;
+    std::ofstream csv_width("results/results_index_width.csv");
+    csv_width << "Matrix,OffsetBits,IndexBits,MB,SerialSeconds,ParallelSeconds,RelativeTo32\n";
+
+    auto run_width = [&](const std::string& name, const CSRView& A) {
+        std::vector<double> x(A.cols, 1.0), y(A.rows, 0.0);
+        double t_base = 0;
+        auto measure = [&](const auto& M) {
+            using Offset = std::remove_const_t<std::remove_reference_t<decltype(M.row_ptr[0])>>;
+            using Index = std::remove_const_t<std::remove_reference_t<decltype(M.col_indices[0])>>;
+            double t_serial = best_of(reps, [&] { csr_spmv(M, x, y); });
+            double t_parallel = best_of(reps, [&] { csr_spmv_parallel(M, x, y); });
+            if (t_base == 0) t_base = t_parallel;
+            double mb = (M.nnz * (sizeof(double) + sizeof(Index)) + (M.rows + 1.0) * sizeof(Offset)) / 1e6;
+            csv_width << name << "," << 8 * sizeof(Offset) << "," << 8 * sizeof(Index) << "," << mb << "," << t_serial
+                      << "," << t_parallel << "," << t_parallel / t_base << "\n";
+            std::cout << "  " << name << " offset " << 8 * sizeof(Offset) << "-bit / index " << 8 * sizeof(Index)
+                      << "-bit: " << mb << " MB, serial " << t_serial << " s, parallel " << t_parallel
+                      << " s (x" << t_parallel / t_base << " of 32-bit)" << std::endl;
+        };
+        measure(A);
+        measure(convert_csr<int64_t, int>(A).view());
+        measure(convert_csr<int64_t, int64_t>(A).view());
+    };
+
+    run_width("PowerLaw", power_law.view());
+    try {
+        AnyCSRMatrix any = readMTX_narrowest("data/mc2depi.mtx");
+        std::visit([&](const auto& M) {
+            std::cout << "  mc2depi loaded with " << 8 * sizeof(M.row_ptr[0]) << "-bit offsets, "
+                      << 8 * sizeof(M.col_indices[0]) << "-bit indices" << std::endl;
+            run_width("mc2depi", convert_csr<int, int>(M.view()).view());
+        }, any);
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_width.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT M: Out-of-core streaming SpMV (bounded memory)
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment M: Streaming SpMV..." << std::endl;
+    std::ofstream csv_stream("results/results_streaming.csv");
+    csv_stream << "Matrix,BudgetMB,Blocks,Seconds,DiskGBps,ComputeGBps,OverlapEfficiency,MaxError\n";
+
+    auto run_streaming = [&](const std::string& name, const std::string& csrbin, const CSRView& reference) {
+        std::vector<double> x(reference.cols), y(reference.rows), y_ref(reference.rows);
+        for (int j = 0; j < reference.cols; j++) x[j] = 1.0 + (j % 7) * 0.125;
+        csr_spmv(reference, x, y_ref);
+        for (size_t budget_mb : {4, 16, 64}) {
+            StreamingStats stats = csr_spmv_streaming(csrbin, x, y, budget_mb << 20);
+            double error = 0;
+            for (int i = 0; i < reference.rows; i++) error = std::max(error, std::fabs(y[i] - y_ref[i]));
+            csv_stream << name << "," << budget_mb << "," << stats.blocks << "," << stats.seconds << ","
+                       << stats.disk_gbps() << "," << stats.compute_gbps() << "," << stats.overlap_efficiency() << ","
+                       << error << "\n";
+            std::cout << "  " << name << " budget " << budget_mb << " MB: " << stats.blocks << " blocks, "
+                      << stats.seconds << " s, disk " << stats.disk_gbps() << " GB/s, compute " << stats.compute_gbps()
+                      << " GB/s, overlap " << stats.overlap_efficiency() << std::endl;
+        }
+    };
+
+    try {
+        std::filesystem::create_directories("data");
+        write_csr_binary(power_law, "data/powerlaw.csrbin");
+        run_streaming("PowerLaw", "data/powerlaw.csrbin", power_law.view());
+        std::remove("data/powerlaw.csrbin");
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping power-law stream (" << e.what() << ")." << std::endl;
+    }
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_streaming("mc2depi", "data/mc2depi.csrbin", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_stream.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT N: Iterative solvers (fused persistent-region kernels)
+    // ---------------------------------------------------------
+    std::cout << "Running Experiment N: Iterative Solvers..." << std::endl;
+    std::ofstream csv_solver("results/results_solvers.csv");
+    csv_solver << "Matrix,Solver,Iterations,Residual,Eigenvalue,SecondsPerIteration,Phase0,Phase1,Phase2,GBps\n";
+    const int solver_iters = 300;
+
+    auto report_solver = [&](const std::string& name, const std::string& solver, const SolverStats& stats) {
+        double per_it = stats.iteration_seconds() / std::max(1, stats.iterations);
+        csv_solver << name << "," << solver << "," << stats.iterations << "," << stats.residual << ","
+                   << stats.eigenvalue << "," << per_it;
+        for (int ph = 0; ph < 3; ph++) {
+            csv_solver << ",";
+            if (ph < (int)stats.phase_seconds.size()) csv_solver << stats.phase_seconds[ph] / std::max(1, stats.iterations);
+        }
+        csv_solver << "," << stats.gbps() << "\n";
+        std::cout << "  " << name << " " << solver << ": " << stats.iterations << " iterations, residual "
+                  << stats.residual;
+        if (stats.eigenvalue != 0) std::cout << ", eigenvalue " << stats.eigenvalue;
+        std::cout << ", " << per_it * 1e3 << " ms/iteration (";
+        for (size_t ph = 0; ph < stats.phase_seconds.size(); ph++)
+            std::cout << (ph ? ", " : "") << stats.phase_names[ph] << " "
+                      << stats.phase_seconds[ph] / std::max(1, stats.iterations) * 1e3;
+        std::cout << "), " << stats.gbps() << " GB/s" << std::endl;
+    };
+
+    auto run_cg = [&](const std::string& name, const CSRView& A) {
+        std::vector<double> b(A.rows, 1.0), x;
+        report_solver(name, "CG", cg_solve(A, b, x, false, 1e-8, solver_iters));
+        report_solver(name, "CG-unfused", cg_solve_unfused(A, b, x, false, 1e-8, solver_iters));
+        report_solver(name, "PCG-Jacobi", cg_solve(A, b, x, true, 1e-8, solver_iters));
+        report_solver(name, "PCG-Jacobi-unfused", cg_solve_unfused(A, b, x, true, 1e-8, solver_iters));
+    };
+    auto run_power = [&](const std::string& name, const CSRView& A) {
+        std::vector<double> v;
+        report_solver(name, "Power", power_iteration(A, v, 1e-10, solver_iters));
+    };
+
+    run_cg("Laplacian2D", laplacian.view());
+    run_power("Laplacian2D", laplacian.view());
+    {
+        CSRMatrix scaled;
+        generate_scaled_laplacian(1000, scaled);
+        run_cg("ScaledLaplacian", scaled.view());
+    }
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_power("mc2depi", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_solver.close();
+
+    // ---------------------------------------------------------
+    // EXPERIMENT O: NUMA placement (one node vs all nodes)
+    // ---------------------------------------------------------
+    // Threads are pinned close (node by node). For each placement the matrix,
+    // x and y are copied anew: serially by the master thread, first-touched
+    // with the merge-path row split, or interleaved over the nodes in use.
+    // LocalFraction is the share of sampled value pages on the node of the
+    // thread that reads them.
+    std::cout << "Running Experiment O: NUMA Placement..." << std::endl;
+    std::ofstream csv_numa("results/results_numa.csv");
+    csv_numa << "Matrix,Nodes,Threads,Placement,Seconds,GBps,LocalFraction,RemotePages\n";
+    const NumaTopology& topology = numa_topology();
+    std::cout << "  " << topology.nodes() << " NUMA node(s) with CPUs" << std::endl;
+    std::vector<int> node_counts = {1};
+    if (topology.nodes() > 1) node_counts.push_back(topology.nodes());
+
+    auto run_numa = [&](const std::string& name, const CSRView& A) {
+        for (int nodes : node_counts) {
+            const int threads = pin_threads(PinPolicy::Close, nodes);
+            for (NumaPolicy policy : {NumaPolicy::Serial, NumaPolicy::FirstTouch, NumaPolicy::Interleave}) {
+                numa_policy() = policy;
+                MergePartition P = merge_path_partition(A, threads);
+                CSRMatrix M = csr_first_touch(A, P.row);
+                KernelVector<double> x = vector_first_touch(A.cols, 1.0, P.row);
+                KernelVector<double> y = vector_first_touch(A.rows, 0.0, P.row);
+                const CSRView view = M.view();
+                double t = best_of(reps, [&] { spmv_kernels.merge(view, P, x.data(), y.data(), nullptr); });
+
+                std::vector<size_t> bounds;
+                for (int r : P.row) bounds.push_back(M.row_ptr[r]);
+                NumaPlacement placement = numa_placement(M.values.data(), M.values.size(), bounds);
+                csv_numa << name << "," << nodes << "," << threads << "," << numa_policy_name(policy) << "," << t << ","
+                         << spmv_bytes(view) / t / 1e9 << "," << placement.local_fraction() << ","
+                         << placement.remote << "\n";
+                std::cout << "  " << name << " " << nodes << " node(s), " << threads << " threads, "
+                          << numa_policy_name(policy) << ": " << t << " s, " << spmv_bytes(view) / t / 1e9
+                          << " GB/s, local " << placement.local_fraction() * 100 << "%" << std::endl;
+            }
+        }
+    };
+
+    run_numa("Laplacian2D", laplacian.view());
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_numa("mc2depi", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
+    }
+    csv_numa.close();
+    numa_policy() = NumaPolicy::FirstTouch;
+    pin_threads(pin);
+
+    // ---------------------------------------------------------
+    // EXPERIMENT P: Page size behind the matrix (4 KB vs 2 MB pages)
+    // ---------------------------------------------------------
+    // Matrix, x and y are copied into fresh 64-byte aligned buffers for each
+    // strategy; with --counters, dTLB misses come from one extra counted call.
+    // Speedup and DTLBReduction are relative to 4 KB pages.
+    std::cout << "Running Experiment P: Huge Pages..." << std::endl;
+    std::ofstream csv_pages("results/results_pages.csv");
+    csv_pages << "Matrix,Pages,HugePageMB,Seconds,GBps,DTLBMisses,Speedup,DTLBReduction\n";
+    const PageStrategy saved_pages = page_strategy();
+
+    auto run_pages = [&](const std::string& name, const CSRView& A) {
+        double base_seconds = 0, base_dtlb = 0;
+        for (PageStrategy strategy : {PageStrategy::Small, PageStrategy::Transparent, PageStrategy::HugeTLB}) {
+            page_strategy() = strategy;
+            MergePartition P = merge_path_partition(A, omp_get_max_threads());
+            long huge_kb = huge_page_kb();
+            CSRMatrix M = csr_first_touch(A, P.row);
+            KernelVector<double> x = vector_first_touch(A.cols, 1.0, P.row);
+            KernelVector<double> y = vector_first_touch(A.rows, 0.0, P.row);
+            huge_kb = huge_page_kb() - huge_kb;
+            const CSRView view = M.view();
+            auto kernel = [&] { spmv_kernels.merge(view, P, x.data(), y.data(), nullptr); };
+            double t = best_of(reps, kernel);
+
+            const std::string region = "pages/" + name + "/" + page_strategy_name(strategy);
+            { PerfScope scope(region, PerfScope::Call); kernel(); }
+            PerfRegionStats counted = perf_region(region);
+            double dtlb = counted.has(PERF_DTLB_MISSES) ? counted.per_call(PERF_DTLB_MISSES) : 0.0;
+            if (strategy == PageStrategy::Small) { base_seconds = t; base_dtlb = dtlb; }
+
+            csv_pages << name << "," << page_strategy_name(strategy) << "," << huge_kb / 1024.0 << "," << t << ","
+                      << spmv_bytes(view) / t / 1e9 << ",";
+            if (dtlb > 0) csv_pages << dtlb;
+            csv_pages << "," << base_seconds / t << ",";
+            if (dtlb > 0) csv_pages << base_dtlb / dtlb;
+            csv_pages << "\n";
+            std::cout << "  " << name << " " << page_strategy_name(strategy) << ": " << huge_kb / 1024.0
+                      << " MB on huge pages, " << t << " s, " << base_seconds / t << "x";
+            if (dtlb > 0) std::cout << ", " << dtlb << " dTLB misses";
+            std::cout << std::endl;
+        }
+    };
+
+    run_pages("Laplacian2D", laplacian.view());
+    try {
+        MappedCSR mapped = load_csr_cached("data/mc2depi.mtx");
+        run_pages("mc2depi", mapped.view());
+    } catch (const std::exception& e) {
+        std::cout << "  Skipping mc2depi (" << e.what() << ")." << std::endl;
     }
+    csv_pages.close();
+    page_strategy() = saved_pages;
 
     return 0;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 import subprocess
+import os
 import matplotlib.pyplot as plt
 import pandas as pd
 import sys
@@ -6,49 +7,251 @@ import re
 
 
 SIZES = [128, 256, 512, 1024, 2048]
-MODES = ["basic", "parallel", "vectorized"]
+MODES = ["basic", "parallel", "vectorized", "blocked", "strassen", "planned", "recursive"]
+# Modes whose result is checked against a double-precision multiply_basic in a separate (untimed)
+# run; with float or mixed every mode is checked. Unchecked rows get NaN in MaxRelError.
+CHECKED_MODES = ["strassen"]
 
 SOURCE = "task3_matrix.cpp"
 EXE = "task3_matrix"
 CSV_FILE = "results/task3_results.csv"
+# Kernel version to benchmark: auto (widest the CPU supports), scalar, sse2, avx2 or avx512
+ISA = sys.argv[1] if len(sys.argv) > 1 else "auto"
+# Element precision: double, float or mixed (float storage, double accumulation)
+PRECISION = sys.argv[2] if len(sys.argv) > 2 else "double"
+# Timed repetitions per run: at least REPS, and more until MIN_TIME seconds are measured
+REPS = 1
+MIN_TIME = 1.0
+# NUMA scaling: these modes at the largest size, on one node and on all nodes, per page placement
+NUMA_MODES = ["parallel", "blocked"]
+NUMA_POLICIES = ["serial", "first-touch", "interleave"]
+NUMA_CSV_FILE = "results/task3_numa.csv"
+# Page backing of the matrices: these modes at the largest size per strategy, relative to 4 KB pages
+PAGE_MODES = ["vectorized", "blocked"]
+PAGE_STRATEGIES = ["small", "thp", "hugetlb"]
+PAGES_CSV_FILE = "results/task3_pages.csv"
+# Prepacked plan: cost per multiply over this many calls sharing one B (prepare once, then execute)
+PLAN_CALLS = [1, 10, 100, 1000]
+PLAN_CSV_FILE = "results/task3_plan.csv"
+# Batched small GEMM: 20 has no specialized kernel and takes the runtime-size path
+BATCH_SIZES = [4, 8, 16, 20, 32, 64]
+BATCH_COUNTS = [10, 100, 1000, 10000]
+BATCH_MODES = ["batched", "batched-generic"]
+BATCH_CSV_FILE = "results/task3_batched.csv"
+# General gemm: (name, M, N, K) for C = op(A) * op(B), C M x N, with every transpose combination
+GEMM_SHAPES = [("square", 2048, 2048, 2048), ("tall-skinny", 32768, 64, 256), ("short-wide", 64, 32768, 256),
+               ("low-rank", 4096, 4096, 32), ("inner-product", 64, 64, 65536)]
+GEMM_TRANS = ["NN", "NT", "TN", "TT"]
+GEMM_CSV_FILE = "results/task3_gemm.csv"
+# Thread scaling at one size: 1, 2, 4, ... threads up to every core (OMP_NUM_THREADS)
+SCALING_SIZE = 1024
+SCALING_MODES = ["parallel", "vectorized", "blocked", "recursive"]
+SCALING_CSV_FILE = "results/task3_scaling.csv"
 
 def compile_code():
     print("Compiling...")
-    cmd = ["g++", "-O3", "-march=native", "-fopenmp", "-mfma", SOURCE, "-o", EXE]
+    # No -march: ISA-specific kernels are selected at runtime, so the binary runs on any x86-64 node
+    cmd = ["g++", "-O3", "-fopenmp", SOURCE, "-o", EXE]
     subprocess.check_call(cmd)
 
-def parse_perf_output(stderr_output):
-    """ Extract cycles, instructions, and cache-misses from perf output """
-    metrics = {"seconds": 0.0, "cache-misses": 0, "instructions": 0, "cycles": 0}
-
-    for line in stderr_output.splitlines():
-        line = line.strip()
-        if "seconds time elapsed" in line:
-            metrics["seconds"] = float(line.split()[0].replace(',', ''))
-        elif "cache-misses" in line:
-            parts = line.split()
-            if parts[0] != "<not":
-                metrics["cache-misses"] = int(parts[0].replace(',', ''))
-        elif "instructions" in line:
-            metrics["instructions"] = int(line.split()[0].replace(',', ''))
-        elif "cycles" in line:
-            metrics["cycles"] = int(line.split()[0].replace(',', ''))
-
-    return metrics
+def parse_bench_output(stdout_output):
+    """ Extract the in-process timing statistics (time is the median repetition) """
+    stats = {}
+    for key, value in re.findall(r"(\w+)=(\S+)", stdout_output):
+        if key in ("time", "gflops", "min", "p95", "stddev", "reps", "gbps", "roofline_gflops", "prepare"):
+            stats[key] = float(value)
+    return stats
+
+COUNTERS = {"cycles": "Cycles", "instructions": "Instructions", "l1d_misses": "L1DMisses",
+            "llc_misses": "LLCMisses", "branch_misses": "BranchMisses", "dtlb_misses": "DTLBMisses"}
+
+def parse_counter_output(stdout_output):
+    """ Extract the per-call hardware counters of every region line
+        (region=kernel is the whole multiply, others are phases inside it; nan = not available) """
+    regions = {}
+    for line in stdout_output.splitlines():
+        if not line.startswith("region="):
+            continue
+        fields = dict(field.split("=", 1) for field in line.split())
+        name = fields.pop("region")
+        regions[name] = {key: float(value) for key, value in fields.items()}
+    return regions
+
+def measure_error(size, mode):
+    """ Run once with --check (separately from the timed run) and return max relative error vs basic """
+    result = subprocess.run([f"./{EXE}", str(size), mode, PRECISION, "--check", f"--isa={ISA}", "--warmup=0",
+                             "--reps=1", "--min-time=0"],
+                            capture_output=True, text=True)
+    match = re.search(r"max_rel_error=(\S+)", result.stdout)
+    return float(match.group(1)) if match else float("nan")
+
+def run_numa_scaling():
+    """ Largest size with threads pinned close on the first node, then on all nodes, for every
+        page placement of A, B and C (local_fraction: share of C's pages on their owner's node) """
+    data = []
+    size = SIZES[-1]
+    base = [f"--isa={ISA}", f"--reps={REPS}", f"--min-time={MIN_TIME}", "--pin=close"]
+    probe = subprocess.run([f"./{EXE}", "8", "basic", PRECISION] + base, capture_output=True, text=True)
+    match = re.search(r"nodes=(\d+)", probe.stdout)
+    nodes_available = int(match.group(1)) if match else 1
+    for nodes in sorted({1, nodes_available}):
+        for mode in NUMA_MODES:
+            for policy in NUMA_POLICIES:
+                result = subprocess.run([f"./{EXE}", str(size), mode, PRECISION, f"--nodes={nodes}",
+                                         f"--numa={policy}"] + base, capture_output=True, text=True)
+                if result.returncode != 0:
+                    print(f"Error in {mode} {size} nodes={nodes} numa={policy}")
+                    continue
+                stats = parse_bench_output(result.stdout)
+                fields = dict(re.findall(r"(threads|local_fraction)=(\S+)", result.stdout))
+                data.append({"Size": size, "Mode": mode, "Precision": PRECISION, "Nodes": nodes,
+                             "Threads": int(fields.get("threads", 0)), "Placement": policy,
+                             "Time": stats["time"], "GFLOPS": stats["gflops"],
+                             "LocalFraction": float(fields.get("local_fraction", "nan"))})
+                print(f"{mode:<12} nodes={nodes} {policy:<12} {stats['time']:<10.4f} {stats['gflops']:<10.2f}")
+    return pd.DataFrame(data)
+
+def run_page_strategies():
+    """ Largest size per page strategy: dTLB misses and time of the kernel, with the speedup and
+        the dTLB miss reduction (small / strategy) against 4 KB pages """
+    data = []
+    size = SIZES[-1]
+    for mode in PAGE_MODES:
+        baseline = None
+        for pages in PAGE_STRATEGIES:
+            result = subprocess.run([f"./{EXE}", str(size), mode, PRECISION, f"--isa={ISA}", f"--reps={REPS}",
+                                     f"--min-time={MIN_TIME}", f"--pages={pages}", "--counters"],
+                                    capture_output=True, text=True)
+            if result.returncode != 0:
+                print(f"Error in {mode} {size} pages={pages}")
+                continue
+            stats = parse_bench_output(result.stdout)
+            kernel = parse_counter_output(result.stdout).get("kernel", {})
+            match = re.search(r"huge_page_kb=(\d+)", result.stdout)
+            record = {"Size": size, "Mode": mode, "Precision": PRECISION, "Pages": pages,
+                      "HugePageMB": int(match.group(1)) / 1024 if match else float("nan"),
+                      "Time": stats["time"], "GFLOPS": stats["gflops"],
+                      "DTLBMisses": kernel.get("dtlb_misses", float("nan"))}
+            if baseline is None:
+                baseline = record
+            record["Speedup"] = baseline["Time"] / record["Time"]
+            record["DTLBReduction"] = (baseline["DTLBMisses"] / record["DTLBMisses"]
+                                       if record["DTLBMisses"] > 0 else float("nan"))
+            data.append(record)
+            print(f"{mode:<12} pages={pages:<8} {stats['time']:<10.4f} {record['Speedup']:<6.2f}x"
+                  f" dTLB {record['DTLBMisses']:.3g}")
+    return pd.DataFrame(data)
+
+def plan_amortization(df):
+    """ Seconds per multiply when one B is used for `calls` multiplies: the plan pays prepare once,
+        vectorized and blocked transpose / pack B on every call """
+    data = []
+    for size in SIZES:
+        rows = df[df["Size"] == size].set_index("Mode")
+        if not {"planned", "vectorized", "blocked"} <= set(rows.index):
+            continue
+        planned = rows.loc["planned"]
+        for calls in PLAN_CALLS:
+            amortized = planned["Prepare"] / calls + planned["Time"]
+            data.append({"Size": size, "Calls": calls, "Prepare": planned["Prepare"], "Execute": planned["Time"],
+                         "PlannedPerCall": amortized, "VectorizedPerCall": rows.loc["vectorized"]["Time"],
+                         "BlockedPerCall": rows.loc["blocked"]["Time"],
+                         "SpeedupVsVectorized": rows.loc["vectorized"]["Time"] / amortized,
+                         "SpeedupVsBlocked": rows.loc["blocked"]["Time"] / amortized})
+    return pd.DataFrame(data)
+
+def run_batched():
+    """ Matrices per second of the batched kernels over matrix size and batch count, with the
+        speedup of the size-specialized kernels over the runtime-size ones """
+    data = []
+    for size in BATCH_SIZES:
+        for count in BATCH_COUNTS:
+            generic = None
+            for mode in reversed(BATCH_MODES):
+                result = subprocess.run([f"./{EXE}", str(size), mode, PRECISION, f"--isa={ISA}", f"--reps={REPS}",
+                                         f"--min-time={MIN_TIME}", f"--batch={count}"],
+                                        capture_output=True, text=True)
+                if result.returncode != 0:
+                    print(f"Error in {mode} {size} batch={count}")
+                    continue
+                stats = parse_bench_output(result.stdout)
+                match = re.search(r"matrices_per_second=([\d.eE+-]+)", result.stdout)
+                record = {"Size": size, "Batch": count, "Mode": mode, "Precision": PRECISION,
+                          "Time": stats["time"], "GFLOPS": stats["gflops"],
+                          "MatricesPerSecond": float(match.group(1)) if match else float("nan")}
+                if generic is None:
+                    generic = record
+                record["Speedup"] = generic["Time"] / record["Time"]
+                data.append(record)
+                print(f"{mode:<16} {size:<4} batch={count:<6} {record['MatricesPerSecond']:<12.4g}"
+                      f" {record['Speedup']:.2f}x")
+    return pd.DataFrame(data)
+
+def run_gemm_shapes():
+    """ gemm on rectangular shapes for each transpose combination; the slowdown column compares
+        each combination with NN of the same shape """
+    data = []
+    for name, m, n, k in GEMM_SHAPES:
+        plain = None
+        for trans in GEMM_TRANS:
+            result = subprocess.run([f"./{EXE}", f"{m}x{n}x{k}", "gemm", PRECISION, f"--isa={ISA}", f"--reps={REPS}",
+                                     f"--min-time={MIN_TIME}", f"--trans={trans}"],
+                                    capture_output=True, text=True)
+            if result.returncode != 0:
+                print(f"Error in gemm {name} trans={trans}")
+                continue
+            stats = parse_bench_output(result.stdout)
+            record = {"Shape": name, "M": m, "N": n, "K": k, "Trans": trans, "Precision": PRECISION,
+                      "Time": stats["time"], "GFLOPS": stats["gflops"], "GBps": stats["gbps"],
+                      "RooflineGFLOPS": stats["roofline_gflops"]}
+            if plain is None:
+                plain = record
+            record["SlowdownVsNN"] = record["Time"] / plain["Time"]
+            data.append(record)
+            print(f"gemm {name:<14} {m}x{n}x{k:<8} {trans} {stats['time']:<10.4f} {stats['gflops']:<8.2f}"
+                  f" {record['SlowdownVsNN']:.2f}x")
+    return pd.DataFrame(data)
+
+def run_thread_scaling():
+    """ SCALING_SIZE with 1 to all cores: time, LLC misses and speedup / parallel efficiency over
+        the same mode on one thread """
+    data = []
+    cores = os.cpu_count() or 1
+    counts = sorted({1 << p for p in range(cores.bit_length()) if 1 << p <= cores} | {cores})
+    for mode in SCALING_MODES:
+        single = None
+        for threads in counts:
+            result = subprocess.run([f"./{EXE}", str(SCALING_SIZE), mode, PRECISION, f"--isa={ISA}", f"--reps={REPS}",
+                                     f"--min-time={MIN_TIME}", "--counters"],
+                                    capture_output=True, text=True, env={**os.environ, "OMP_NUM_THREADS": str(threads)})
+            if result.returncode != 0:
+                print(f"Error in {mode} {SCALING_SIZE} threads={threads}")
+                continue
+            stats = parse_bench_output(result.stdout)
+            kernel = parse_counter_output(result.stdout).get("kernel", {})
+            record = {"Size": SCALING_SIZE, "Mode": mode, "Precision": PRECISION, "Threads": threads,
+                      "Time": stats["time"], "GFLOPS": stats["gflops"],
+                      "CacheMisses": kernel.get("llc_misses", float("nan"))}
+            if single is None:
+                single = record
+            record["Speedup"] = single["Time"] / record["Time"]
+            record["Efficiency"] = record["Speedup"] / threads
+            data.append(record)
+            print(f"{mode:<12} threads={threads:<4} {stats['time']:<10.4f} {record['Speedup']:<6.2f}x"
+                  f" LLC {record['CacheMisses']:.3g}")
+    return pd.DataFrame(data)
 
 def run_benchmarks():
     data = []
-    print(f"{'Mode':<12} {'Size':<6} {'Time(s)':<10} {'GFLOPS':<10} {'CacheMiss':<12}")
+    print(f"{'Mode':<12} {'Size':<6} {'Time(s)':<10} {'GFLOPS':<10} {'CacheMiss':<12} {'MaxRelErr'}")
     print("-" * 60)
 
     for size in SIZES:
         for mode in MODES:
-            # Construct perf command
-            cmd = [
-                "perf", "stat",
-                "-e", "cache-misses,cycles,instructions",
-                f"./{EXE}", str(size), mode
-            ]
+            # Timing and counters both come from the binary itself: the kernel only,
+            # without setup (counters via perf_event_open, empty when not permitted)
+            cmd = [f"./{EXE}", str(size), mode, PRECISION, f"--isa={ISA}", f"--reps={REPS}",
+                   f"--min-time={MIN_TIME}", "--counters"]
 
             # Run command
             result = subprocess.run(cmd, capture_output=True, text=True)
@@ -57,31 +260,56 @@ def run_benchmarks():
                 print(f"Error in {mode} {size}")
                 continue
 
-            metrics = parse_perf_output(result.stderr)
+            stats = parse_bench_output(result.stdout)
+            regions = parse_counter_output(result.stdout)
+            kernel = regions.get("kernel", {})
 
             # Calculate GFLOPS: (2 * N^3) / Time / 10^9
-            gflops = (2 * (size**3)) / metrics["seconds"] / 1e9
+            gflops = (2 * (size**3)) / stats["time"] / 1e9
 
             record = {
                 "Size": size,
                 "Mode": mode,
-                "Time": metrics["seconds"],
+                "Precision": PRECISION,
+                "Time": stats["time"],
                 "GFLOPS": gflops,
-                "CacheMisses": metrics["cache-misses"],
-                "Instructions": metrics["instructions"],
-                "Cycles": metrics["cycles"],
-                "IPC": metrics["instructions"] / metrics["cycles"] if metrics["cycles"] > 0 else 0
+                "Min": stats["min"],
+                "P95": stats["p95"],
+                "Stddev": stats["stddev"],
+                "Reps": int(stats["reps"]),
+                "GBps": stats["gbps"],
+                "RooflineGFLOPS": stats["roofline_gflops"],
+                "Prepare": stats.get("prepare", 0.0),
+                "CacheMisses": kernel.get("llc_misses", float("nan")),
+                "Instructions": kernel.get("instructions", float("nan")),
+                "Cycles": kernel.get("cycles", float("nan")),
+                "IPC": kernel.get("instructions", float("nan")) / kernel["cycles"] if kernel.get("cycles") else float("nan"),
+                "L1DMisses": kernel.get("l1d_misses", float("nan")),
+                "BranchMisses": kernel.get("branch_misses", float("nan")),
+                "DTLBMisses": kernel.get("dtlb_misses", float("nan")),
+                "MaxRelError": (measure_error(size, mode) if mode in CHECKED_MODES or PRECISION != "double"
+                                else float("nan"))
             }
+            # Phases marked inside the kernel (e.g. vectorized: transpose, fma) as <Phase><Metric> columns
+            for phase, values in regions.items():
+                if phase == "kernel":
+                    continue
+                record[f"{phase.capitalize()}Seconds"] = values["seconds"]
+                for key, column in COUNTERS.items():
+                    record[f"{phase.capitalize()}{column}"] = values.get(key, float("nan"))
             data.append(record)
 
-            print(f"{mode:<12} {size:<6} {metrics['seconds']:<10.4f} {gflops:<10.2f} {metrics['cache-misses']:<12}")
+            print(f"{mode:<12} {size:<6} {stats['time']:<10.4f} {gflops:<10.2f} {record['CacheMisses']:<12.0f}"
+                  f" {record['MaxRelError']:.2e}")
 
     return pd.DataFrame(data)
 
 def generate_plots(df):
     plt.style.use('seaborn-v0_8-whitegrid')
-    colors = {'basic': 'red', 'parallel': 'orange', 'vectorized': 'green'}
-    markers = {'basic': 'o', 'parallel': 's', 'vectorized': '^'}
+    colors = {'basic': 'red', 'parallel': 'orange', 'vectorized': 'green', 'blocked': 'blue', 'strassen': 'purple',
+              'planned': 'brown', 'recursive': 'teal'}
+    markers = {'basic': 'o', 'parallel': 's', 'vectorized': '^', 'blocked': 'D', 'strassen': 'v', 'planned': 'P',
+               'recursive': 'X'}
 
     def plot_metric(metric_col, ylabel, title, filename, log_y=False):
         plt.figure(figsize=(10, 6))
@@ -123,7 +351,7 @@ def generate_plots(df):
     plt.figure(figsize=(10, 6))
     basic_df = df[df["Mode"] == "basic"].set_index("Size")["Time"]
 
-    for mode in ["parallel", "vectorized"]:
+    for mode in MODES[1:]:
         subset = df[df["Mode"] == mode].set_index("Size")
         common_sizes = basic_df.index.intersection(subset.index)
         if common_sizes.empty: continue
@@ -148,3 +376,9 @@ if __name__ == "__main__":
     df = run_benchmarks()
     df.to_csv(CSV_FILE, index=False)
     generate_plots(df)
+    plan_amortization(df).to_csv(PLAN_CSV_FILE, index=False)
+    run_numa_scaling().to_csv(NUMA_CSV_FILE, index=False)
+    run_page_strategies().to_csv(PAGES_CSV_FILE, index=False)
+    run_batched().to_csv(BATCH_CSV_FILE, index=False)
+    run_gemm_shapes().to_csv(GEMM_CSV_FILE, index=False)
+    run_thread_scaling().to_csv(SCALING_CSV_FILE, index=False)
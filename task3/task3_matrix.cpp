@@ -5,79 +5,1011 @@
 #include <omp.h>
 #include <immintrin.h>
 #include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <type_traits>
+#include "../common/cpu_dispatch.hpp"
+#include "../common/bench.hpp"
+#include "../common/memory.hpp"
+#include "../common/numa.hpp"
 
-using Scalar = double;
+// Precisions: element type stored in the matrices (Scalar) and the type
+// products are accumulated in (Acc). Every kernel is templated on one of these.
+// Matrices are KernelVectors: 64-byte aligned, on huge pages when large
+// (--pages), and allocating one does not touch its pages, so the first
+// parallel write decides their NUMA node (see first_touch).
+struct Double { using Scalar = double; using Acc = double; static constexpr const char* name = "double"; };
+struct Float  { using Scalar = float;  using Acc = float;  static constexpr const char* name = "float"; };
+struct Mixed  { using Scalar = float;  using Acc = double; static constexpr const char* name = "mixed"; };
 
-void init_matrix(std::vector<Scalar>& M, int N) {
+template <class Prec>
+using Matrix = KernelVector<typename Prec::Scalar>;
+
+// Fills M (one N x N matrix, or a batch of them back to back) with uniform [0, 1)
+void init_matrix(std::vector<double>& M) {
     std::mt19937 gen(42);
-    std::uniform_real_distribution<Scalar> dis(0.0, 1.0);
-    for (int i = 0; i < N * N; ++i) M[i] = dis(gen);
+    std::uniform_real_distribution<double> dis(0.0, 1.0);
+    for (size_t i = 0; i < M.size(); ++i) M[i] = dis(gen);
 }
 
 // 1. Basic
-void multiply_basic(const std::vector<Scalar>& A, const std::vector<Scalar>& B, std::vector<Scalar>& C, int N) {
+template <class Prec>
+void multiply_basic(const Matrix<Prec>& A, const Matrix<Prec>& B, Matrix<Prec>& C, int N) {
+    using Acc = typename Prec::Acc;
     for (int i = 0; i < N; ++i) {
         for (int j = 0; j < N; ++j) {
-            Scalar sum = 0.0;
-            for (int k = 0; k < N; ++k) sum += A[i * N + k] * B[k * N + j];
+            Acc sum = 0.0;
+            for (int k = 0; k < N; ++k) sum += (Acc)A[i * N + k] * B[k * N + j];
             C[i * N + j] = sum;
         }
     }
 }
 
 // 2. Parallel (No Transpose)
-void multiply_parallel(const std::vector<Scalar>& A, const std::vector<Scalar>& B, std::vector<Scalar>& C, int N) {
-    #pragma omp parallel for schedule(dynamic)
+template <class Prec>
+void multiply_parallel(const Matrix<Prec>& A, const Matrix<Prec>& B, Matrix<Prec>& C, int N) {
+    using Acc = typename Prec::Acc;
+    // Static, so each thread's rows of A and C are the ones it first-touched
+    #pragma omp parallel for schedule(static)
     for (int i = 0; i < N; ++i) {
         for (int j = 0; j < N; ++j) {
-            Scalar sum = 0.0;
-            for (int k = 0; k < N; ++k) sum += A[i * N + k] * B[k * N + j];
+            Acc sum = 0.0;
+            for (int k = 0; k < N; ++k) sum += (Acc)A[i * N + k] * B[k * N + j];
             C[i * N + j] = sum;
         }
     }
 }
 
+// ISA-specific kernels
+// The hot inner kernels are compiled once per instruction set and precision
+// from gemm_kernels.inc; the binary itself only assumes the x86-64 baseline,
+// so it runs everywhere and uses AVX-512 where present. gemm_kernels<Prec> is
+// chosen once at startup (detect_isa, or --isa=<name>). Register tiles are
+// MR x NR with NR = 2 vectors, so float tiles are twice as wide as double ones.
+constexpr int MR = 6;       // register tile rows, shared by every ISA and precision
+constexpr int NR_MAX = 32;  // widest register tile (AVX-512 float)
+
+namespace isa_scalar {
+template <class Prec>
+struct Simd {
+    using Scalar = typename Prec::Scalar;
+    using V = typename Prec::Acc;
+    static constexpr int W = 1, NR = 8;
+    static V zero() { return 0; }
+    static constexpr size_t ALIGN = sizeof(Scalar);
+    static V load(const Scalar* p) { return *p; }
+    static V load_aligned(const Scalar* p) { return *p; }
+    static void store(Scalar* p, V v) { *p = v; }
+    static V set1(Scalar x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V fmadd(V a, V b, V c) { return a * b + c; }
+    static V hsum(V v) { return v; }
+};
+#include "gemm_kernels.inc"
+}
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+namespace isa_sse2 {
+template <class Prec> struct Simd;
+template <> struct Simd<Double> {
+    using V = __m128d;
+    static constexpr int W = 2, NR = 4;
+    static V zero() { return _mm_setzero_pd(); }
+    static constexpr size_t ALIGN = 16;
+    static V load(const double* p) { return _mm_loadu_pd(p); }
+    static V load_aligned(const double* p) { return _mm_load_pd(p); }
+    static void store(double* p, V v) { _mm_storeu_pd(p, v); }
+    static V set1(double x) { return _mm_set1_pd(x); }
+    static V add(V a, V b) { return _mm_add_pd(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static double hsum(V v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+};
+template <> struct Simd<Float> {
+    using V = __m128;
+    static constexpr int W = 4, NR = 8;
+    static V zero() { return _mm_setzero_ps(); }
+    static constexpr size_t ALIGN = 16;
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static V load_aligned(const float* p) { return _mm_load_ps(p); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V set1(float x) { return _mm_set1_ps(x); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static float hsum(V v) {
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+    }
+};
+template <> struct Simd<Mixed> : Simd<Double> {
+    static constexpr size_t ALIGN = 8;
+    static V load(const float* p) { return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)p))); }
+    static V load_aligned(const float* p) { return load(p); }
+    static void store(float* p, V v) { _mm_store_sd((double*)p, _mm_castps_pd(_mm_cvtpd_ps(v))); }
+    static V set1(float x) { return _mm_set1_pd(x); }
+};
+#include "gemm_kernels.inc"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace isa_avx2 {
+template <class Prec> struct Simd;
+template <> struct Simd<Double> {
+    using V = __m256d;
+    static constexpr int W = 4, NR = 8;
+    static V zero() { return _mm256_setzero_pd(); }
+    static constexpr size_t ALIGN = 32;
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static V load_aligned(const double* p) { return _mm256_load_pd(p); }
+    static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static V set1(double x) { return _mm256_set1_pd(x); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+    static double hsum(V v) {
+        __m128d lo = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+};
+template <> struct Simd<Float> {
+    using V = __m256;
+    static constexpr int W = 8, NR = 16;
+    static V zero() { return _mm256_setzero_ps(); }
+    static constexpr size_t ALIGN = 32;
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static V load_aligned(const float* p) { return _mm256_load_ps(p); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static V set1(float x) { return _mm256_set1_ps(x); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    static float hsum(V v) {
+        __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+        return _mm_cvtss_f32(_mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1)));
+    }
+};
+template <> struct Simd<Mixed> : Simd<Double> {
+    static constexpr size_t ALIGN = 16;
+    static V load(const float* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+    static V load_aligned(const float* p) { return _mm256_cvtps_pd(_mm_load_ps(p)); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, _mm256_cvtpd_ps(v)); }
+    static V set1(float x) { return _mm256_set1_pd(x); }
+};
+#include "gemm_kernels.inc"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+namespace isa_avx512 {
+template <class Prec> struct Simd;
+template <> struct Simd<Double> {
+    using V = __m512d;
+    static constexpr int W = 8, NR = 16;
+    static V zero() { return _mm512_setzero_pd(); }
+    static constexpr size_t ALIGN = 64;
+    static V load(const double* p) { return _mm512_loadu_pd(p); }
+    static V load_aligned(const double* p) { return _mm512_load_pd(p); }
+    static void store(double* p, V v) { _mm512_storeu_pd(p, v); }
+    static V set1(double x) { return _mm512_set1_pd(x); }
+    static V add(V a, V b) { return _mm512_add_pd(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+    static double hsum(V v) {
+        alignas(64) double lanes[W];
+        _mm512_store_pd(lanes, v);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+};
+template <> struct Simd<Float> {
+    using V = __m512;
+    static constexpr int W = 16, NR = 32;
+    static V zero() { return _mm512_setzero_ps(); }
+    static constexpr size_t ALIGN = 64;
+    static V load(const float* p) { return _mm512_loadu_ps(p); }
+    static V load_aligned(const float* p) { return _mm512_load_ps(p); }
+    static void store(float* p, V v) { _mm512_storeu_ps(p, v); }
+    static V set1(float x) { return _mm512_set1_ps(x); }
+    static V add(V a, V b) { return _mm512_add_ps(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+    static float hsum(V v) {
+        alignas(64) float lanes[W];
+        _mm512_store_ps(lanes, v);
+        float sum = 0.0f;
+        for (int i = 0; i < W; ++i) sum += lanes[i];
+        return sum;
+    }
+};
+// Masked conversions with a zero source (the unmasked ones trip -Wmaybe-uninitialized in GCC 12)
+template <> struct Simd<Mixed> : Simd<Double> {
+    static constexpr size_t ALIGN = 32;
+    static V load(const float* p) { return _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(p)); }
+    static V load_aligned(const float* p) { return _mm512_maskz_cvtps_pd(0xFF, _mm256_load_ps(p)); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, _mm512_maskz_cvtpd_ps(0xFF, v)); }
+    static V set1(float x) { return _mm512_set1_pd(x); }
+};
+#include "gemm_kernels.inc"
+}
+#pragma GCC pop_options
+
+template <class Prec>
+struct GemmKernels {
+    using Scalar = typename Prec::Scalar;
+    Isa isa;
+    int nr;
+    typename Prec::Acc (*dot)(const Scalar* a, const Scalar* b, int n);
+    void (*micro_kernel)(int kc, const Scalar* Ap, const Scalar* Bp, Scalar* C, int ldc, bool accumulate);
+    void (*leaf)(const Scalar* A, int lda, const Scalar* B, int ldb, Scalar* C, int ldc, int m, int n, int k,
+                 bool accumulate);
+    using BatchKernel = void (*)(int n, const Scalar* A, size_t stride_a, const Scalar* B, size_t stride_b, Scalar* C,
+                                 size_t stride_c, int count);
+    BatchKernel batch;      // size-specialized small products
+    BatchKernel batch_any;  // runtime-sized fallback only
+};
+
+template <class Prec>
+static GemmKernels<Prec> gemm_kernels_for(Isa isa) {
+    switch (isa) {
+        case Isa::AVX512:
+            return { isa, isa_avx512::Simd<Prec>::NR, isa_avx512::dot<Prec>, isa_avx512::micro_kernel<Prec>, isa_avx512::leaf<Prec>,
+                     isa_avx512::small_gemm_batch<Prec>, isa_avx512::small_gemm_batch_any<Prec> };
+        case Isa::AVX2:
+            return { isa, isa_avx2::Simd<Prec>::NR, isa_avx2::dot<Prec>, isa_avx2::micro_kernel<Prec>, isa_avx2::leaf<Prec>,
+                     isa_avx2::small_gemm_batch<Prec>, isa_avx2::small_gemm_batch_any<Prec> };
+        case Isa::SSE2:
+            return { isa, isa_sse2::Simd<Prec>::NR, isa_sse2::dot<Prec>, isa_sse2::micro_kernel<Prec>, isa_sse2::leaf<Prec>,
+                     isa_sse2::small_gemm_batch<Prec>, isa_sse2::small_gemm_batch_any<Prec> };
+        default:
+            return { isa, isa_scalar::Simd<Prec>::NR, isa_scalar::dot<Prec>, isa_scalar::micro_kernel<Prec>, isa_scalar::leaf<Prec>,
+                     isa_scalar::small_gemm_batch<Prec>, isa_scalar::small_gemm_batch_any<Prec> };
+    }
+}
+
+template <class Prec>
+static GemmKernels<Prec> gemm_kernels = gemm_kernels_for<Prec>(detect_isa());
+
 // 3. Vectorized + Parallel + Transposed
-void multiply_vectorized(const std::vector<Scalar>& A, const std::vector<Scalar>& B, std::vector<Scalar>& C, int N) {
-    std::vector<Scalar> B_T(N * N);
+template <class Prec>
+void multiply_vectorized(const Matrix<Prec>& A, const Matrix<Prec>& B, Matrix<Prec>& C, int N) {
+    Matrix<Prec> B_T(N * N);
 
     // Transpose B
+    {
+        PerfScope scope("vectorized/transpose");
+        #pragma omp parallel for
+        for (int i = 0; i < N; ++i)
+            for (int j = 0; j < N; ++j)
+                B_T[i * N + j] = B[j * N + i];
+    }
+
+    PerfScope scope("vectorized/fma");
     #pragma omp parallel for
     for (int i = 0; i < N; ++i)
         for (int j = 0; j < N; ++j)
-            B_T[i * N + j] = B[j * N + i];
+            C[i * N + j] = gemm_kernels<Prec>.dot(&A[i * N], &B_T[j * N], N);
+}
 
-    #pragma omp parallel for
-    for (int i = 0; i < N; ++i) {
-        for (int j = 0; j < N; ++j) {
-            __m256d vec_sum = _mm256_setzero_pd();
-            int k = 0;
-            for (; k <= N - 4; k += 4) {
-                __m256d vec_A = _mm256_loadu_pd(&A[i * N + k]);
-                __m256d vec_B = _mm256_loadu_pd(&B_T[j * N + k]);
-                vec_sum = _mm256_fmadd_pd(vec_A, vec_B, vec_sum);
+// 4. Blocked (BLIS-style packed panels + MR x NR register tile)
+// Loop order jc -> pc -> ic -> jr -> ir. A KC x NC panel of B is packed once per
+// (jc, pc) and shared by all threads (L3), each thread packs its own MC x KC
+// block of A (L2), and the micro-kernel streams one KC x NR sliver of B (L1)
+// against an MR x KC sliver of A with MR*NR accumulators held in registers.
+// For Mixed, partial sums are rounded to float in C between KC panels.
+// gemm() is the general entry point (rectangular, transposes, alpha/beta,
+// leading dimensions); multiply_blocked is its square, plain case.
+constexpr int MC = 96;
+constexpr int KC = 256;
+constexpr int NC = 2048;
+
+// A block (mc x kc) -> slivers of MR rows, stored k-major, zero-padded to MR,
+// scaled by alpha. trans: the block is read from A^T (element (i, k) at
+// A[k * lda + i]), one contiguous row of A^T per k, so a transposed A is
+// never materialized.
+template <class Scalar>
+static void pack_A(const Scalar* A, int lda, int mc, int kc, Scalar* Ap, bool trans = false, Scalar alpha = 1) {
+    if (trans) {
+        for (int k = 0; k < kc; ++k) {
+            const Scalar* src = &A[(size_t)k * lda];
+            for (int i = 0; i < mc; i += MR) {
+                int mr = std::min(MR, mc - i);
+                Scalar* dst = Ap + (size_t)i * kc + k * MR;
+                for (int r = 0; r < mr; ++r) dst[r] = alpha * src[i + r];
+                for (int r = mr; r < MR; ++r) dst[r] = 0.0;
             }
-            double temp[4];
-            _mm256_storeu_pd(temp, vec_sum);
-            Scalar sum = temp[0] + temp[1] + temp[2] + temp[3];
-            for (; k < N; ++k) sum += A[i * N + k] * B_T[j * N + k];
-            C[i * N + j] = sum;
+        }
+        return;
+    }
+    for (int i = 0; i < mc; i += MR) {
+        int mr = std::min(MR, mc - i);
+        for (int k = 0; k < kc; ++k) {
+            for (int r = 0; r < mr; ++r) *Ap++ = alpha * A[(size_t)(i + r) * lda + k];
+            for (int r = mr; r < MR; ++r) *Ap++ = 0.0;
+        }
+    }
+}
+
+// B panel (kc x nc) -> slivers of NR columns, stored k-major, zero-padded to NR.
+// trans: the panel is read from B^T (element (k, j) at B[j * ldb + k]).
+template <class Scalar>
+static void pack_B(const Scalar* B, int ldb, int kc, int nc, int NR, Scalar* Bp, bool trans = false) {
+    for (int j = 0; j < nc; j += NR) {
+        int nr = std::min(NR, nc - j);
+        Scalar* dst = Bp + j * kc;
+        for (int k = 0; k < kc; ++k) {
+            if (trans)
+                for (int c = 0; c < nr; ++c) *dst++ = B[(size_t)(j + c) * ldb + k];
+            else
+                for (int c = 0; c < nr; ++c) *dst++ = B[(size_t)k * ldb + j + c];
+            for (int c = nr; c < NR; ++c) *dst++ = 0.0;
+        }
+    }
+}
+
+// Edge tiles (mr < MR or nr < NR) go through a full-size scratch tile
+template <class Prec>
+static void micro_kernel_edge(int mr, int nr, int kc, const typename Prec::Scalar* Ap, const typename Prec::Scalar* Bp,
+                              typename Prec::Scalar* C, int ldc, bool accumulate) {
+    const int NR = gemm_kernels<Prec>.nr;
+    alignas(64) typename Prec::Scalar tile[MR * NR_MAX];
+    gemm_kernels<Prec>.micro_kernel(kc, Ap, Bp, tile, NR, false);
+    for (int r = 0; r < mr; ++r)
+        for (int c = 0; c < nr; ++c)
+            C[r * ldc + c] = accumulate ? C[r * ldc + c] + tile[r * NR + c] : tile[r * NR + c];
+}
+
+// C[0..M, jc..jc+nc) (+)= alpha * op(A)[0..M, pc..pc+kc) * Bp, with Bp the
+// packed kc x nc panel of B and op(A) = A^T when trans_a. Macro-tiles of C are
+// independent: one MC block of rows per task, and when there are fewer row
+// blocks than threads (short, wide C) each is also split into column ranges of
+// whole slivers. Call from inside a parallel region (the loop is an orphaned
+// omp for); Ap is the calling thread's MC x KC workspace.
+template <class Prec>
+static void blocked_panel(const typename Prec::Scalar* A, int lda, int M, int pc, int kc, int jc, int nc,
+                          const typename Prec::Scalar* Bp, typename Prec::Scalar* Ap, typename Prec::Scalar* C, int ldc,
+                          bool accumulate, bool trans_a = false, typename Prec::Scalar alpha = 1) {
+    using Scalar = typename Prec::Scalar;
+    const GemmKernels<Prec>& kernels = gemm_kernels<Prec>;
+    const int NR = kernels.nr;
+    const int row_blocks = (M + MC - 1) / MC;
+    const int slivers = (nc + NR - 1) / NR;
+    int col_blocks = std::min(slivers, std::max(1, (omp_get_num_threads() + row_blocks - 1) / row_blocks));
+    const int block_slivers = (slivers + col_blocks - 1) / col_blocks;
+    col_blocks = (slivers + block_slivers - 1) / block_slivers;
+    #pragma omp for schedule(dynamic)
+    for (int task = 0; task < row_blocks * col_blocks; ++task) {
+        int ic = task / col_blocks * MC;
+        int mc = std::min(MC, M - ic);
+        int j0 = task % col_blocks * block_slivers * NR;
+        int j1 = std::min(nc, j0 + block_slivers * NR);
+        pack_A(trans_a ? &A[(size_t)pc * lda + ic] : &A[(size_t)ic * lda + pc], lda, mc, kc, Ap, trans_a, alpha);
+
+        for (int jr = j0; jr < j1; jr += NR) {
+            int nr = std::min(NR, nc - jr);
+            for (int ir = 0; ir < mc; ir += MR) {
+                int mr = std::min(MR, mc - ir);
+                Scalar* c = &C[(size_t)(ic + ir) * ldc + jc + jr];
+                const Scalar* ap = &Ap[(size_t)ir * kc];
+                const Scalar* bp = &Bp[(size_t)jr * kc];
+                if (mr == MR && nr == NR) kernels.micro_kernel(kc, ap, bp, c, ldc, accumulate);
+                else micro_kernel_edge<Prec>(mr, nr, kc, ap, bp, c, ldc, accumulate);
+            }
+        }
+    }
+}
+
+enum class Transpose { No, Yes };
+
+// C = alpha * op(A) * op(B) + beta * C, with op(X) = X or X^T, C M x N, op(A)
+// M x K and op(B) K x N. All three are row-major with leading dimensions, so
+// each can be a sub-matrix of a larger one. Transposes and alpha are applied
+// while packing (pack_A / pack_B read either layout), so nothing is copied
+// besides the usual panels. beta = 0 overwrites C without reading it (NaNs
+// included), beta = 1 accumulates in place, and any other beta scales C once
+// before the first panel. K = 0 or alpha = 0 only applies beta.
+template <class Prec>
+void gemm(Transpose trans_a, Transpose trans_b, int M, int N, int K, typename Prec::Scalar alpha,
+          const typename Prec::Scalar* A, int lda, const typename Prec::Scalar* B, int ldb,
+          typename Prec::Scalar beta, typename Prec::Scalar* C, int ldc) {
+    if (M <= 0 || N <= 0) return;
+    const bool ta = trans_a == Transpose::Yes, tb = trans_b == Transpose::Yes;
+    const bool scale_only = K <= 0 || alpha == 0;
+    const int NR = gemm_kernels<Prec>.nr;
+    const int nc_max = std::min(NC, (N + NR - 1) / NR * NR);
+    Matrix<Prec> Bp(scale_only ? 0 : (size_t)std::min(KC, K) * nc_max);
+
+    #pragma omp parallel
+    {
+        if (beta != 1 && (scale_only || beta != 0)) {
+            #pragma omp for schedule(static)
+            for (int i = 0; i < M; ++i)
+                for (int j = 0; j < N; ++j) C[(size_t)i * ldc + j] = beta == 0 ? 0 : beta * C[(size_t)i * ldc + j];
+        }
+
+        if (!scale_only) {
+            Matrix<Prec> Ap((size_t)MC * KC);
+            for (int jc = 0; jc < N; jc += NC) {
+                int nc = std::min(NC, N - jc);
+                for (int pc = 0; pc < K; pc += KC) {
+                    int kc = std::min(KC, K - pc);
+
+                    // Pack the shared B panel, one NR sliver per iteration
+                    #pragma omp for schedule(static)
+                    for (int j = 0; j < nc; j += NR)
+                        pack_B(tb ? &B[(size_t)(jc + j) * ldb + pc] : &B[(size_t)pc * ldb + jc + j], ldb, kc,
+                               std::min(NR, nc - j), NR, &Bp[(size_t)j * kc], tb);
+
+                    blocked_panel<Prec>(A, lda, M, pc, kc, jc, nc, Bp.data(), Ap.data(), C, ldc, pc > 0 || beta != 0,
+                                        ta, alpha);
+                }
+            }
+        }
+    }
+}
+
+template <class Prec>
+void multiply_blocked(const Matrix<Prec>& A, const Matrix<Prec>& B, Matrix<Prec>& C, int N) {
+    gemm<Prec>(Transpose::No, Transpose::No, N, N, N, 1, A.data(), N, B.data(), N, 0, C.data(), N);
+}
+
+// 5. Strassen (7 recursive products, OpenMP tasks, preallocated workspace)
+// N is zero-padded to P = m * 2^levels with m <= cutoff so every level splits
+// evenly. The top task_levels levels run their 7 products as OpenMP tasks, each
+// with a private slice of the workspace; deeper levels run sequentially and
+// reuse one slice. Leaves use the dispatched 4 x NR register-tile kernel.
+constexpr int STRASSEN_DEFAULT_CUTOFF = 128;
+
+// Operand of one product: X, or X + sign * Y when Y is set
+template <class Scalar>
+struct StrassenOperand {
+    const Scalar* X;
+    const Scalar* Y;
+    int sign;
+};
+
+// Contribution of M1..M7 to the quadrants C11, C12, C21, C22
+static const int STRASSEN_COEF[7][4] = {
+    { 1, 0, 0, 1 }, { 0, 0, 1, -1 }, { 0, 1, 0, 1 }, { 1, 0, 1, 0 },
+    { -1, 1, 0, 0 }, { 0, 0, 0, 1 }, { 1, 0, 0, 0 },
+};
+
+static size_t strassen_workspace(int n, int cutoff, int task_levels) {
+    if (n <= cutoff) return 0;
+    size_t hh = (size_t)(n / 2) * (n / 2);
+    if (task_levels > 0) {
+        // 5 products need an S temp, 5 need a T temp, all 7 need M
+        return 17 * hh + 7 * strassen_workspace(n / 2, cutoff, task_levels - 1);
+    }
+    return 3 * hh + strassen_workspace(n / 2, cutoff, 0);
+}
+
+template <class Prec>
+static void strassen_rec(const typename Prec::Scalar* A, int lda, const typename Prec::Scalar* B, int ldb,
+                         typename Prec::Scalar* C, int ldc, int n, int cutoff, int task_levels, typename Prec::Scalar* ws);
+
+// Forms S/T if needed (into the slot), then M = S * T
+template <class Prec, class Scalar = typename Prec::Scalar>
+static void strassen_product(const StrassenOperand<Scalar>& a, const StrassenOperand<Scalar>& b, int lda, int ldb, int h,
+                             int cutoff, int task_levels, Scalar* S, Scalar* T, Scalar* M, Scalar* ws) {
+    const Scalar* left = a.X; int ldl = lda;
+    const Scalar* right = b.X; int ldr = ldb;
+    if (a.Y) {
+        for (int i = 0; i < h; ++i)
+            for (int j = 0; j < h; ++j) S[i * h + j] = a.X[i * lda + j] + a.sign * a.Y[i * lda + j];
+        left = S; ldl = h;
+    }
+    if (b.Y) {
+        for (int i = 0; i < h; ++i)
+            for (int j = 0; j < h; ++j) T[i * h + j] = b.X[i * ldb + j] + b.sign * b.Y[i * ldb + j];
+        right = T; ldr = h;
+    }
+    strassen_rec<Prec>(left, ldl, right, ldr, M, h, h, cutoff, task_levels, ws);
+}
+
+// C quadrants += coef * M
+template <class Scalar>
+static void strassen_accumulate(const Scalar* M, const int* coef, Scalar* C, int ldc, int h) {
+    Scalar* quad[4] = { C, C + h, C + (size_t)h * ldc, C + (size_t)h * ldc + h };
+    for (int q = 0; q < 4; ++q) {
+        if (coef[q] == 0) continue;
+        for (int i = 0; i < h; ++i)
+            for (int j = 0; j < h; ++j) quad[q][i * ldc + j] += coef[q] * M[i * h + j];
+    }
+}
+
+template <class Prec>
+static void strassen_rec(const typename Prec::Scalar* A, int lda, const typename Prec::Scalar* B, int ldb,
+                         typename Prec::Scalar* C, int ldc, int n, int cutoff, int task_levels, typename Prec::Scalar* ws) {
+    using Scalar = typename Prec::Scalar;
+    if (n <= cutoff) {
+        gemm_kernels<Prec>.leaf(A, lda, B, ldb, C, ldc, n, n, n, false);
+        return;
+    }
+    const int h = n / 2;
+    const size_t hh = (size_t)h * h;
+    const Scalar *A11 = A, *A12 = A + h, *A21 = A + (size_t)h * lda, *A22 = A21 + h;
+    const Scalar *B11 = B, *B12 = B + h, *B21 = B + (size_t)h * ldb, *B22 = B21 + h;
+
+    const StrassenOperand<Scalar> ops[7][2] = {
+        { { A11, A22, 1 }, { B11, B22, 1 } },
+        { { A21, A22, 1 }, { B11, nullptr, 0 } },
+        { { A11, nullptr, 0 }, { B12, B22, -1 } },
+        { { A22, nullptr, 0 }, { B21, B11, -1 } },
+        { { A11, A12, 1 }, { B22, nullptr, 0 } },
+        { { A21, A11, -1 }, { B11, B12, 1 } },
+        { { A12, A22, -1 }, { B21, B22, 1 } },
+    };
+
+    for (int i = 0; i < n; ++i) std::fill(C + (size_t)i * ldc, C + (size_t)i * ldc + n, Scalar(0));
+
+    if (task_levels > 0) {
+        const size_t sub = strassen_workspace(h, cutoff, task_levels - 1);
+        Scalar* M[7];
+        Scalar* p = ws;
+        for (int m = 0; m < 7; ++m) {
+            Scalar* S = ops[m][0].Y ? p : nullptr; p += ops[m][0].Y ? hh : 0;
+            Scalar* T = ops[m][1].Y ? p : nullptr; p += ops[m][1].Y ? hh : 0;
+            M[m] = p; p += hh;
+            Scalar* sub_ws = p; p += sub;
+            #pragma omp task firstprivate(m, S, T, sub_ws) shared(ops, M)
+            strassen_product<Prec>(ops[m][0], ops[m][1], lda, ldb, h, cutoff, task_levels - 1, S, T, M[m], sub_ws);
+        }
+        #pragma omp taskwait
+        for (int m = 0; m < 7; ++m) strassen_accumulate(M[m], STRASSEN_COEF[m], C, ldc, h);
+    } else {
+        Scalar *S = ws, *T = ws + hh, *M = ws + 2 * hh, *sub_ws = ws + 3 * hh;
+        for (int m = 0; m < 7; ++m) {
+            strassen_product<Prec>(ops[m][0], ops[m][1], lda, ldb, h, cutoff, 0, S, T, M, sub_ws);
+            strassen_accumulate(M, STRASSEN_COEF[m], C, ldc, h);
+        }
+    }
+}
+
+template <class Prec>
+void multiply_strassen(const Matrix<Prec>& A, const Matrix<Prec>& B, Matrix<Prec>& C, int N,
+                       int cutoff = STRASSEN_DEFAULT_CUTOFF) {
+    using Scalar = typename Prec::Scalar;
+    cutoff = std::max(cutoff, 8);
+    int levels = 0, m = N;
+    while (m > cutoff) { m = (m + 1) / 2; ++levels; }
+    const int P = m << levels;
+
+    // Enough task levels to give every thread a product (7 or 49 tasks)
+    int task_levels = 0;
+    for (int t = 1; t < omp_get_max_threads() && task_levels < std::min(levels, 2); t *= 7) ++task_levels;
+
+    const size_t pp = (size_t)P * P;
+    const bool padded = P != N;
+    Matrix<Prec> workspace(strassen_workspace(P, cutoff, task_levels) + (padded ? 3 * pp : 0), Scalar(0));
+    Scalar* ws = workspace.data();
+
+    const Scalar* Ap = A.data();
+    const Scalar* Bp = B.data();
+    Scalar* Cp = C.data();
+    if (padded) {
+        Scalar* Apad = ws; Scalar* Bpad = ws + pp; Cp = ws + 2 * pp;
+        for (int i = 0; i < N; ++i) {
+            std::copy(&A[(size_t)i * N], &A[(size_t)i * N] + N, Apad + (size_t)i * P);
+            std::copy(&B[(size_t)i * N], &B[(size_t)i * N] + N, Bpad + (size_t)i * P);
+        }
+        Ap = Apad; Bp = Bpad; ws += 3 * pp;
+    }
+
+    #pragma omp parallel
+    #pragma omp single
+    strassen_rec<Prec>(Ap, P, Bp, P, Cp, P, P, cutoff, task_levels, ws);
+
+    if (padded)
+        for (int i = 0; i < N; ++i) std::copy(Cp + (size_t)i * P, Cp + (size_t)i * P + N, &C[(size_t)i * N]);
+}
+
+// 6. Prepacked plan: B packed once, reused by every multiply
+// gemm_prepare packs all of a K x N matrix B into the blocked kernel's layout
+// (every KC x NC panel as NR-wide k-major slivers, zero-padded) in parallel,
+// and allocates one MC x KC A workspace per thread. gemm_execute then runs the
+// blocked loop nest against the packed panels without packing B or
+// allocating. A plan is valid for one kernel selection (gemm_kernels<Prec>)
+// and at most plan.threads threads.
+template <class Prec>
+struct GemmPlan {
+    int K = 0, N = 0, nr = 0, threads = 0;
+    Matrix<Prec> Bp;                         // packed panels, jc-major then pc
+    std::vector<size_t> panel;               // offset of panel (jc / NC, pc / KC) in Bp
+    std::vector<Matrix<Prec>> workspace;     // per-thread packed A block
+
+    size_t panel_offset(int jc, int pc) const { return panel[(size_t)(jc / NC) * ((K + KC - 1) / KC) + pc / KC]; }
+};
+
+template <class Prec>
+GemmPlan<Prec> gemm_prepare(const typename Prec::Scalar* B, int K, int N, int ldb) {
+    GemmPlan<Prec> plan;
+    plan.K = K; plan.N = N;
+    plan.nr = gemm_kernels<Prec>.nr;
+    plan.threads = omp_get_max_threads();
+    const int NR = plan.nr;
+
+    size_t size = 0;
+    for (int jc = 0; jc < N; jc += NC) {
+        int nc_padded = (std::min(NC, N - jc) + NR - 1) / NR * NR;
+        for (int pc = 0; pc < K; pc += KC) {
+            plan.panel.push_back(size);
+            size += (size_t)std::min(KC, K - pc) * nc_padded;
+        }
+    }
+    plan.Bp.resize(size);
+    plan.workspace.resize(plan.threads);
+
+    // Each sliver reads kc contiguous runs of NR elements, so packing is one
+    // pass over B; threads share the slivers of every panel
+    #pragma omp parallel num_threads(plan.threads)
+    {
+        plan.workspace[omp_get_thread_num()].resize((size_t)MC * KC);
+        for (int jc = 0; jc < N; jc += NC) {
+            int nc = std::min(NC, N - jc);
+            for (int pc = 0; pc < K; pc += KC) {
+                int kc = std::min(KC, K - pc);
+                typename Prec::Scalar* dst = &plan.Bp[plan.panel_offset(jc, pc)];
+                #pragma omp for schedule(static) nowait
+                for (int j = 0; j < nc; j += NR)
+                    pack_B(&B[(size_t)pc * ldb + jc + j], ldb, kc, std::min(NR, nc - j), NR, dst + (size_t)j * kc);
+            }
+        }
+    }
+    return plan;
+}
+
+// C (M x plan.N) = A (M x plan.K) * B
+template <class Prec>
+void gemm_execute(GemmPlan<Prec>& plan, const typename Prec::Scalar* A, int lda, int M, typename Prec::Scalar* C,
+                  int ldc) {
+    #pragma omp parallel num_threads(std::min(plan.threads, omp_get_max_threads()))
+    {
+        typename Prec::Scalar* Ap = plan.workspace[omp_get_thread_num()].data();
+        for (int jc = 0; jc < plan.N; jc += NC) {
+            int nc = std::min(NC, plan.N - jc);
+            for (int pc = 0; pc < plan.K; pc += KC)
+                blocked_panel<Prec>(A, lda, M, pc, std::min(KC, plan.K - pc), jc, nc, &plan.Bp[plan.panel_offset(jc, pc)],
+                                    Ap, C, ldc, pc > 0);
+        }
+    }
+}
+
+// 7. Batched small GEMM
+// C[b] = A[b] * B[b] for count independent n x n products (4 x 4 to 64 x 64 is
+// the target), matrix b of X at X + b * stride_x. Threads split the batch
+// into contiguous ranges instead of splitting each matrix, and every range
+// runs the kernel specialized for n (small_gemm_batch). Batches with less
+// work than BATCH_PARALLEL_FLOPS stay on the calling thread: starting a
+// parallel region would cost more than the products. specialized = false
+// forces the runtime-sized kernel, for comparison.
+constexpr double BATCH_PARALLEL_FLOPS = 2e5;
+
+template <class Prec>
+void gemm_batched(int n, const typename Prec::Scalar* A, size_t stride_a, const typename Prec::Scalar* B,
+                  size_t stride_b, typename Prec::Scalar* C, size_t stride_c, int count, bool specialized = true) {
+    auto kernel = specialized ? gemm_kernels<Prec>.batch : gemm_kernels<Prec>.batch_any;
+    if (2.0 * n * n * n * count < BATCH_PARALLEL_FLOPS || omp_get_max_threads() == 1) {
+        kernel(n, A, stride_a, B, stride_b, C, stride_c, count);
+        return;
+    }
+    #pragma omp parallel
+    {
+        const int t = omp_get_thread_num(), T = omp_get_num_threads();
+        const size_t b0 = (size_t)count * t / T, b1 = (size_t)count * (t + 1) / T;
+        kernel(n, A + b0 * stride_a, stride_a, B + b0 * stride_b, stride_b, C + b0 * stride_c, stride_c, (int)(b1 - b0));
+    }
+}
+
+// 8. Recursive (cache-oblivious, OpenMP tasks)
+// C (+)= A * B is halved along its largest dimension until a subproblem has
+// at most RECURSIVE_LEAF_VOLUME multiply-adds, which the leaf kernel computes
+// in place. Halving the largest side keeps subproblems close to cubic, so at
+// some depth the three operands fit each cache level whatever its size; there
+// are no cache block sizes to tune. Halves over M or N write disjoint parts of
+// C and run as OpenMP tasks, which idle threads take from the team's queue, so
+// the load balances when N does not divide evenly. Halves over K update the
+// same C and run one after the other. Subproblems smaller than
+// RECURSIVE_TASK_VOLUME run on the current thread.
+constexpr double RECURSIVE_LEAF_VOLUME = 64.0 * 64 * 64;
+constexpr double RECURSIVE_TASK_VOLUME = 128.0 * 128 * 128;
+
+// Half of n, rounded down to a multiple of q when that leaves both parts non-empty
+static int recursive_split(int n, int q) {
+    int h = n / 2 / q * q;
+    return h > 0 ? h : n / 2;
+}
+
+template <class Prec>
+static void recursive_rec(const typename Prec::Scalar* A, int lda, const typename Prec::Scalar* B, int ldb,
+                          typename Prec::Scalar* C, int ldc, int m, int n, int k, bool accumulate) {
+    const double volume = (double)m * n * k;
+    if (volume <= RECURSIVE_LEAF_VOLUME) {
+        gemm_kernels<Prec>.leaf(A, lda, B, ldb, C, ldc, m, n, k, accumulate);
+        return;
+    }
+    const bool spawn = volume > RECURSIVE_TASK_VOLUME;
+    if (m >= n && m >= k) {
+        // Row halves align to the leaf's 4-row tile
+        int h = recursive_split(m, 4);
+        #pragma omp task if(spawn)
+        recursive_rec<Prec>(A, lda, B, ldb, C, ldc, h, n, k, accumulate);
+        recursive_rec<Prec>(A + (size_t)h * lda, lda, B, ldb, C + (size_t)h * ldc, ldc, m - h, n, k, accumulate);
+        #pragma omp taskwait
+    } else if (n >= k) {
+        int h = recursive_split(n, gemm_kernels<Prec>.nr);
+        #pragma omp task if(spawn)
+        recursive_rec<Prec>(A, lda, B, ldb, C, ldc, m, h, k, accumulate);
+        recursive_rec<Prec>(A, lda, B + h, ldb, C + h, ldc, m, n - h, k, accumulate);
+        #pragma omp taskwait
+    } else {
+        int h = recursive_split(k, 1);
+        recursive_rec<Prec>(A, lda, B, ldb, C, ldc, m, n, h, accumulate);
+        recursive_rec<Prec>(A + h, lda, B + (size_t)h * ldb, ldb, C, ldc, m, n, k - h, true);
+    }
+}
+
+template <class Prec>
+void multiply_recursive(const Matrix<Prec>& A, const Matrix<Prec>& B, Matrix<Prec>& C, int N) {
+    #pragma omp parallel
+    #pragma omp single
+    recursive_rec<Prec>(A.data(), N, B.data(), N, C.data(), N, N, N, N, false);
+}
+
+// Prints how far C deviates from multiply_basic in double precision on the
+// original (unrounded) inputs (elementwise, relative to |ref|), over all count
+// N x N products of a batch
+template <class Scalar>
+void report_error_vs_basic(const std::vector<double>& A64, const std::vector<double>& B64, const KernelVector<Scalar>& C,
+                           int N, int count = 1) {
+    const size_t NN = (size_t)N * N;
+    Matrix<Double> A(NN), B(NN), ref(NN);
+    double max_abs = 0.0, max_rel = 0.0;
+    for (int b = 0; b < count; ++b) {
+        std::copy(A64.begin() + b * NN, A64.begin() + (b + 1) * NN, A.begin());
+        std::copy(B64.begin() + b * NN, B64.begin() + (b + 1) * NN, B.begin());
+        multiply_basic<Double>(A, B, ref, N);
+        for (size_t i = 0; i < NN; ++i) {
+            double err = std::fabs((double)C[b * NN + i] - ref[i]);
+            max_abs = std::max(max_abs, err);
+            if (ref[i] != 0.0) max_rel = std::max(max_rel, err / std::fabs(ref[i]));
         }
     }
+    std::cout << "max_abs_error=" << max_abs << " max_rel_error=" << max_rel << std::endl;
+}
+
+// Operands of the gemm mode: op(A) M x K, op(B) K x N, C M x N, each stored
+// row-major with pad unused elements at the end of every row (a sub-matrix
+// view of a wider one). The square modes use the default N x N x N, no pad.
+struct GemmArgs {
+    int M = 0, N = 0, K = 0;
+    Transpose trans_a = Transpose::No, trans_b = Transpose::No;
+    double alpha = 1.0, beta = 0.0;
+    int pad = 0;
+
+    bool ta() const { return trans_a == Transpose::Yes; }
+    bool tb() const { return trans_b == Transpose::Yes; }
+    int a_rows() const { return ta() ? K : M; }
+    int lda() const { return (ta() ? M : K) + pad; }
+    int b_rows() const { return tb() ? N : K; }
+    int ldb() const { return (tb() ? K : N) + pad; }
+    int ldc() const { return N + pad; }
+};
+
+// Prints how far C deviates from alpha * op(A) * op(B) + beta * C0 computed in
+// double on the unrounded inputs; the padding of C must still hold C0
+template <class Scalar>
+void report_gemm_error(const GemmArgs& g, const std::vector<double>& A64, const std::vector<double>& B64,
+                       const std::vector<double>& C64, const KernelVector<Scalar>& C) {
+    double max_abs = 0.0, max_rel = 0.0;
+    for (int i = 0; i < g.M; ++i)
+        for (int j = 0; j < g.ldc(); ++j) {
+            double ref = C64[(size_t)i * g.ldc() + j];
+            if (j < g.N) {
+                double sum = 0.0;
+                for (int k = 0; k < g.K; ++k)
+                    sum += A64[g.ta() ? (size_t)k * g.lda() + i : (size_t)i * g.lda() + k] *
+                           B64[g.tb() ? (size_t)j * g.ldb() + k : (size_t)k * g.ldb() + j];
+                ref = g.alpha * sum + g.beta * ref;
+            }
+            double err = std::fabs((double)C[(size_t)i * g.ldc() + j] - ref);
+            max_abs = std::max(max_abs, err);
+            if (ref != 0.0) max_rel = std::max(max_rel, err / std::fabs(ref));
+        }
+    std::cout << "max_abs_error=" << max_abs << " max_rel_error=" << max_rel << std::endl;
+}
+
+// One "region=<name> seconds=... cycles=..." line, counters per call ("nan" if unavailable)
+void print_counters(const std::string& name, const PerfRegionStats& region) {
+    std::cout << "region=" << name << " seconds=" << region.seconds / std::max(1L, region.calls);
+    for (int e = 0; e < PERF_EVENTS; ++e) {
+        std::cout << " " << perf_event_key(e) << "=";
+        if (region.has(e)) std::cout << region.per_call(e);
+        else std::cout << "nan";
+    }
+    std::cout << std::endl;
+}
+
+// Runs one mode in the given precision. Inputs are generated in double so every
+// precision multiplies the same matrices (rounded to float for Float/Mixed).
+// Only the multiply is timed (config.warmup runs, then repetitions); setup and
+// the --check reference are outside the measurement. With a json path the
+// statistics are also written there. The gemm mode takes its shape, transposes,
+// alpha, beta and padding from shape; every other mode needs M = N = K.
+template <class Prec>
+int run_mode(const GemmArgs& shape, int batch, const std::string& mode, int cutoff, bool check, Isa isa,
+             const BenchConfig& config, const std::string& json) {
+    using Scalar = typename Prec::Scalar;
+    const bool general = mode == "gemm";
+    const int N = shape.N;
+    if (!general && (shape.M != N || shape.K != N)) {
+        std::cerr << "Mode " << mode << " needs a square size (N, not MxNxK)" << std::endl;
+        return 1;
+    }
+    const GemmArgs g = general ? shape : GemmArgs{N, N, N};
+    gemm_kernels<Prec> = gemm_kernels_for<Prec>(isa);
+    machine_roofline(isa);
+    std::cout << "isa=" << isa_name(isa) << " precision=" << Prec::name << std::endl;
+
+    // The batched modes multiply count independent N x N matrices stored back to back
+    const bool batched = mode == "batched" || mode == "batched-generic";
+    const int count = batched ? batch : 1;
+    const size_t NN = (size_t)N * N;
+    std::vector<double> A64((size_t)g.a_rows() * g.lda() * count), B64((size_t)g.b_rows() * g.ldb() * count);
+    std::vector<double> C64(general ? (size_t)g.M * g.ldc() : 0);
+    init_matrix(A64);
+    init_matrix(B64);
+    init_matrix(C64);
+    // Each thread touches the rows it computes first, so they sit on its node
+    Matrix<Prec> A(A64.size()), B(B64.size()), C((size_t)g.M * g.ldc() * count);
+    first_touch_copy(A64.data(), A.data(), A.size());
+    first_touch_copy(B64.data(), B.data(), B.size());
+    if (general) first_touch_copy(C64.data(), C.data(), C.size());
+    else first_touch(C.data(), C.size());
+    if (!check) {
+        std::vector<double>().swap(A64);
+        std::vector<double>().swap(B64);
+    }
+
+    // planned: B is packed once per plan (timed on its own as prepare=), and
+    // only gemm_execute is timed, as when one B is multiplied by many A's
+    GemmPlan<Prec> plan;
+    double prepare_seconds = 0;
+    std::function<void()> kernel;
+    if (mode == "basic") kernel = [&] { multiply_basic<Prec>(A, B, C, N); };
+    else if (mode == "parallel") kernel = [&] { multiply_parallel<Prec>(A, B, C, N); };
+    else if (mode == "vectorized") kernel = [&] { multiply_vectorized<Prec>(A, B, C, N); };
+    else if (mode == "blocked") kernel = [&] { multiply_blocked<Prec>(A, B, C, N); };
+    else if (mode == "strassen") kernel = [&] { multiply_strassen<Prec>(A, B, C, N, cutoff); };
+    else if (mode == "recursive") kernel = [&] { multiply_recursive<Prec>(A, B, C, N); };
+    else if (mode == "planned") {
+        prepare_seconds = bench_measure(config, [&] { plan = gemm_prepare<Prec>(B.data(), N, N, N); }).median;
+        kernel = [&] { gemm_execute<Prec>(plan, A.data(), N, N, C.data(), N); };
+    }
+    else if (batched) {
+        bool specialized = mode == "batched";
+        kernel = [&, specialized] { gemm_batched<Prec>(N, A.data(), NN, B.data(), NN, C.data(), NN, count, specialized); };
+    }
+    else if (general) {
+        kernel = [&] {
+            gemm<Prec>(g.trans_a, g.trans_b, g.M, g.N, g.K, (Scalar)g.alpha, A.data(), g.lda(), B.data(), g.ldb(),
+                       (Scalar)g.beta, C.data(), g.ldc());
+        };
+    }
+    else {
+        std::cerr << "Unknown mode: " << mode << std::endl;
+        return 1;
+    }
+
+    // Compulsory traffic: A and B read once, C written once (and read when beta != 0).
+    // The FMAs run in Acc, so Float is held to the float peak and Mixed to the double one.
+    const std::string size = general ? bench_str(g.M) + "x" + bench_str(g.N) + "x" + bench_str(g.K) : bench_str(N);
+    const double c_passes = general && g.beta != 0 ? 2.0 : 1.0;
+    BenchSuite bench(config, "Mode");
+    bench.add(mode, {{"Size", size}, {"Batch", bench_str(count)}, {"Precision", Prec::name}},
+              2.0 * g.M * g.N * (double)g.K * count,
+              ((double)g.M * g.K + (double)g.K * g.N + c_passes * g.M * g.N) * count * sizeof(Scalar), kernel,
+              std::is_same_v<typename Prec::Acc, float>);
+    const BenchResult& r = bench.run(false).back();
+    std::cout << "time=" << r.stats.median << " gflops=" << r.gflops() << " min=" << r.stats.min
+              << " p95=" << r.stats.p95 << " stddev=" << r.stats.stddev << " reps=" << r.stats.reps
+              << " gbps=" << r.gbps() << " roofline_gflops=" << r.roofline_gflops << std::endl;
+    if (mode == "planned") std::cout << "prepare=" << prepare_seconds << std::endl;
+    if (batched) std::cout << "batch=" << count << " matrices_per_second=" << count / r.stats.median << std::endl;
+    if (general)
+        std::cout << "shape=" << size << " trans=" << (g.ta() ? "T" : "N") << (g.tb() ? "T" : "N")
+                  << " alpha=" << g.alpha << " beta=" << g.beta << " pad=" << g.pad << std::endl;
+    // Counters per call: the whole multiply, then any phases the kernel marks
+    // (phases are counted only during that extra call, not the timed ones)
+    if (perf_enabled()) {
+        print_counters("kernel", r.counters);
+        for (const PerfRegionStats& region : perf_regions())
+            if (region.name.rfind(mode + "/", 0) == 0) print_counters(region.name.substr(mode.size() + 1), region);
+    }
+    if (!json.empty()) bench.write_json(json);
+    // Share of C's pages on the node of the thread that owns them under the static row split
+    NumaPlacement placement = numa_placement(C.data(), C.size());
+    std::cout << "numa=" << numa_policy_name(numa_policy()) << " threads=" << omp_get_max_threads()
+              << " nodes=" << numa_topology().nodes() << " local_fraction=" << placement.local_fraction() << std::endl;
+    std::cout << "pages=" << page_strategy_name(page_strategy()) << " huge_page_kb=" << huge_page_kb() << std::endl;
+
+    // gemm: C has been updated by every repetition, so redo one call from C0
+    if (check && general) {
+        first_touch_copy(C64.data(), C.data(), C.size());
+        kernel();
+        report_gemm_error<Scalar>(g, A64, B64, C64, C);
+    }
+    else if (check) report_error_vs_basic<Scalar>(A64, B64, C, N, count);
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
     if (argc < 3) return 1;
-    int N = std::stoi(argv[1]);
+    // Size: N (square) or MxNxK (gemm mode: C M x N, inner dimension K)
+    GemmArgs shape;
+    std::string size = argv[1];
+    if (std::sscanf(size.c_str(), "%dx%dx%d", &shape.M, &shape.N, &shape.K) != 3)
+        shape.M = shape.N = shape.K = std::stoi(size);
     std::string mode = argv[2];
 
-    std::vector<Scalar> A(N * N), B(N * N), C(N * N);
-    init_matrix(A, N);
-    init_matrix(B, N);
+    // Optional precision after mode: double (default), float, mixed (float storage, double accumulation)
+    std::string precision = "double";
+    int first_flag = 3;
+    if (argc > 3 && std::string(argv[3]).rfind("--", 0) != 0) precision = argv[first_flag++];
 
-    if (mode == "basic") multiply_basic(A, B, C, N);
-    else if (mode == "parallel") multiply_parallel(A, B, C, N);
-    else if (mode == "vectorized") multiply_vectorized(A, B, C, N);
+    // Optional flags: --cutoff=<n> (strassen leaf size), --check (compare against double basic),
+    // --isa=<scalar|sse2|avx2|avx512|auto> (force a kernel version), --warmup=<n>, --reps=<n>
+    // (minimum repetitions), --min-time=<s> (minimum measured time), --json=<path> (write statistics),
+    // --counters (hardware counters per kernel and phase via perf_event_open),
+    // --numa=<serial|first-touch|interleave> (page placement of A, B, C; default first-touch),
+    // --pin=<none|close|spread> (bind one thread per CPU), --nodes=<n> (use only the first n NUMA nodes),
+    // --pages=<small|thp|hugetlb> (page size behind the matrices; default thp),
+    // --batch=<count> (number of N x N products in the batched modes; default 1000),
+    // gemm mode only: --trans=<NN|NT|TN|TT> (op(A), op(B)), --alpha=<a>, --beta=<b> (default 1, 0),
+    // --pad=<n> (unused elements after every row of A, B and C)
+    int cutoff = STRASSEN_DEFAULT_CUTOFF;
+    int batch = 1000;
+    bool check = false;
+    std::string isa, json;
+    PinPolicy pin = PinPolicy::None;
+    int nodes = 0;
+    BenchConfig config;
+    config.min_reps = 3;
+    for (int i = first_flag; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--check") check = true;
+        else if (arg.rfind("--cutoff=", 0) == 0) cutoff = std::stoi(arg.substr(9));
+        else if (arg.rfind("--isa=", 0) == 0) isa = arg.substr(6);
+        else if (arg.rfind("--warmup=", 0) == 0) config.warmup = std::stoi(arg.substr(9));
+        else if (arg.rfind("--reps=", 0) == 0) config.min_reps = std::stoi(arg.substr(7));
+        else if (arg.rfind("--min-time=", 0) == 0) config.min_seconds = std::stod(arg.substr(11));
+        else if (arg.rfind("--json=", 0) == 0) json = arg.substr(7);
+        else if (arg == "--counters" && perf_enable(true) == 0)
+            std::cerr << "Warning: hardware counters not available, timing only" << std::endl;
+        else if (arg == "--numa=serial") numa_policy() = NumaPolicy::Serial;
+        else if (arg == "--numa=first-touch") numa_policy() = NumaPolicy::FirstTouch;
+        else if (arg == "--numa=interleave") numa_policy() = NumaPolicy::Interleave;
+        else if (arg == "--pin=close") pin = PinPolicy::Close;
+        else if (arg == "--pin=spread") pin = PinPolicy::Spread;
+        else if (arg.rfind("--nodes=", 0) == 0) nodes = std::stoi(arg.substr(8));
+        else if (arg.rfind("--batch=", 0) == 0) batch = std::stoi(arg.substr(8));
+        else if (arg.rfind("--trans=", 0) == 0 && arg.size() == 10) {
+            shape.trans_a = arg[8] == 'T' ? Transpose::Yes : Transpose::No;
+            shape.trans_b = arg[9] == 'T' ? Transpose::Yes : Transpose::No;
+        }
+        else if (arg.rfind("--alpha=", 0) == 0) shape.alpha = std::stod(arg.substr(8));
+        else if (arg.rfind("--beta=", 0) == 0) shape.beta = std::stod(arg.substr(7));
+        else if (arg.rfind("--pad=", 0) == 0) shape.pad = std::stoi(arg.substr(6));
+        else if (arg == "--pages=small") page_strategy() = PageStrategy::Small;
+        else if (arg == "--pages=thp") page_strategy() = PageStrategy::Transparent;
+        else if (arg == "--pages=hugetlb") page_strategy() = PageStrategy::HugeTLB;
+    }
+    // --nodes without --pin still restricts the team to those nodes' CPUs
+    if (pin != PinPolicy::None || nodes > 0) pin_threads(pin == PinPolicy::None ? PinPolicy::Close : pin, nodes);
+    Isa selected = select_isa(isa);
 
-    return 0;
-}
\ No newline at end of file
+    if (precision == "double") return run_mode<Double>(shape, batch, mode, cutoff, check, selected, config, json);
+    if (precision == "float") return run_mode<Float>(shape, batch, mode, cutoff, check, selected, config, json);
+    if (precision == "mixed") return run_mode<Mixed>(shape, batch, mode, cutoff, check, selected, config, json);
+    std::cerr << "Unknown precision: " << precision << std::endl;
+    return 1;
+}